@@ -6,7 +6,7 @@ uint8_t readMem(uint16_t address);
 void showDiskMotor(uint16_t address, int q)
 {
 	address &= 7;
-	LOG("Motor%d %d PC %04X: %d %d %d%d%d%d %d\n",curDrv, disk[curDrv].motorOn, getPC(), address>>1, address&1,
+	LOG("Motor%d %d PC %04X: %d %d %d%d%d%d %d\n",curDrv, disk[curDrv].motorOn, getPC(&cpu), address>>1, address&1,
 		phs[curDrv][0], phs[curDrv][1], phs[curDrv][2], phs[curDrv][3], q);
 }
 
@@ -33,10 +33,10 @@ void showRWTS()
 {
 	uint16_t IOB;
 
-	IOB = getA();
+	IOB = getA(&cpu);
 	IOB = IOB<<8;
-	IOB = IOB|getY();
-	LOG("RWTS SP:%04X(%02X%02X) IOB %04X CMD %d T %d S %d >> %02X%02X\n", getSP(), readMem(0x100+getSP()+2), readMem(0x100+getSP()+1), IOB, readMem(IOB+12), readMem(IOB+4), readMem(IOB+5), readMem(IOB+9), readMem(IOB+8));
+	IOB = IOB|getY(&cpu);
+	LOG("RWTS SP:%04X(%02X%02X) IOB %04X CMD %d T %d S %d >> %02X%02X\n", getSP(&cpu), readMem(0x100+getSP(&cpu)+2), readMem(0x100+getSP(&cpu)+1), IOB, readMem(IOB+12), readMem(IOB+4), readMem(IOB+5), readMem(IOB+9), readMem(IOB+8));
 }
 
 #endif	// APPLE2LOG_H_
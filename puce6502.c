@@ -6,6 +6,9 @@
   This version has been modified for reinette II plus, a french Apple II plus
   emulator using SDL2 (https://github.com/ArthurFerreira2/reinette-II-plus).
 
+  Built with PUCE6502_CMOS it is the 65C02 of reinette IIe instead, see
+  puce65c02.c : both CPUs are expanded from the opcode table of puce6502ops.h.
+
   Please download the latest version from
   https://github.com/ArthurFerreira2/puce6502
 
@@ -31,10 +34,25 @@
 //#define ENABLE_LOG
 //#include "stb/log.h"
 
+#ifdef PUCE6502_JIT
+	#define _DEFAULT_SOURCE  // mmap() flags under -std=c11
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef PUCE6502_JIT
+	#include <stddef.h>
+	#ifdef _WIN32
+		#include <windows.h>
+	#else
+		#include <sys/mman.h>
+	#endif
+#endif
+
 
 // set to zero for 'normal' use
 // or to 1 if you want to run the functionnal tests
@@ -55,1782 +73,846 @@
 
 	// for functionnal tests, see main()
 	uint8_t RAM[65536];
-	inline uint8_t readMem(uint16_t address) { return RAM[address]; }
-	inline void writeMem(uint16_t address, uint8_t value) { RAM[address] = value; }
+	static inline uint8_t readRAM(puce6502_t *cpu, uint16_t address) { return RAM[address]; }
+	static inline void writeRAM(puce6502_t *cpu, uint16_t address, uint8_t value) { RAM[address] = value; }
+	#define readMem(address)         readRAM(cpu, address)
+	#define writeMem(address, value) writeRAM(cpu, address, value)
+
+#elif defined(PUCE6502_MEMMAP)
+
+	// memory map provided by the machine as a header, its memRead() and
+	// memWrite() are inlined in place of the calls to readMem() and writeMem()
+	#include PUCE6502_MEMMAP
+	#define readMem(address)         memRead(cpu, address)
+	#define writeMem(address, value) memWrite(cpu, address, value)
 
 #else
 
-	// user provided functions
-	extern uint8_t readMem(uint16_t address);
-	extern void writeMem(uint16_t address, uint8_t value);
+	// user provided functions, reached through the CPU context
+	#define readMem(address)         cpu->readMem(cpu, address)
+	#define writeMem(address, value) cpu->writeMem(cpu, address, value)
 
 #endif
 
 
-unsigned long long int ticks = 0;  // accumulated number of clock cycles
+// the registers live in the puce6502_t context passed to every function
+#define PC    (cpu->PC)
+#define A     (cpu->A)
+#define X     (cpu->X)
+#define Y     (cpu->Y)
+#define SP    (cpu->SP)
+#define P     (cpu->P)
+#define ticks (cpu->ticks)
+#define state (cpu->state)  // 65C02 only
+#define NZ    (cpu->nz)
+
+// N and Z are derived from the last result instead of being stored in P
+#define FLAG_N       ((NZ & 0x180) != 0)
+#define FLAG_Z       (!(NZ & 0xFF))
+#define SET_Z(value) (NZ = FLAG_N << 8 | ((value) != 0))  // Z alone, N unchanged
+#define GET_P()      ((P.byte & ~(SIGN | ZERO)) | FLAG_N << 7 | FLAG_Z << 1)
+#define SET_P(value) (P.byte = (value), NZ = (P.byte & SIGN) << 1 | !(P.byte & ZERO))
+
+#include "puce6502ops.h"
 
+/*
+  Idle loops :
+
+  Built with PUCE6502_IDLE and given cpu->idle, the core watches the short
+  loops closed by a backward branch. The user counts in polls the reads that
+  found nothing to do (KBD with no key) and in events the other I/O accesses,
+  the core counts the writes. A loop running PUCE6502_IDLE_ITERATIONS times in
+  a row with polls and no events waits for a key : idle is set, so that the
+  machine sleeps instead of spinning until its next frame. If these runs made
+  no writes either and left the registers as they were, nothing can change
+  before an input or an interrupt and puce6502Exec() also skips to the end of
+  its budget. Loops counting while they wait, in memory as the monitor's KEYIN
+  does for the random seed and the enhanced IIe for the cursor blink, or in a
+  register for a timeout, run their whole budget so these counts stay true.
+*/
 
-static uint16_t PC;  //  Program Counter
-static uint8_t A, X, Y, SP;  // Accumulator, X and y indexes and Stack Pointer
-static union {
-	uint8_t byte;
-  struct {
-    uint8_t C : 1;  // Carry
-    uint8_t Z : 1;  // Zero
-    uint8_t I : 1;  // Interupt-disable
-    uint8_t D : 1;  // Decimal
-    uint8_t B : 1;  // Break
-    uint8_t U : 1;  // Undefined
-    uint8_t V : 1;  // Overflow
-    uint8_t S : 1;  // Sign
-  };
-} P;  // Processor Status
+#ifdef PUCE6502_IDLE
+
+// a backward branch from end to loop was just taken, true if the rest of the
+// budget can be skipped
+static inline int spinCheck(puce6502_t *cpu, uint16_t loop, uint16_t end) {
+	puce6502_idle_t *idle = cpu->idle;
+	if ((uint16_t)(end - loop) > PUCE6502_IDLE_SIZE)
+		return 0;  // too long to tell
+	uint64_t registers = (uint64_t)GET_P() << 32 | (uint32_t)SP << 24 | Y << 16 | X << 8 | A;
+	if (loop != idle->loop || idle->events || !idle->polls) {
+		idle->loop = loop;  // watched from now on
+		idle->iterations = idle->quiet = 0;
+	} else {
+		if (idle->iterations < PUCE6502_IDLE_ITERATIONS)
+			idle->iterations++;
+		if (idle->quiet < PUCE6502_IDLE_ITERATIONS)
+			idle->quiet = idle->writes || registers != idle->registers ? 0 : idle->quiet + 1;
+		if (idle->iterations == PUCE6502_IDLE_ITERATIONS)
+			idle->idle = 1;
+	}
+	idle->polls = idle->events = idle->writes = 0;
+	idle->registers = registers;
+	return idle->quiet == PUCE6502_IDLE_ITERATIONS;
+}
+
+#define SPIN_WRITE() ((void)(cpu->idle && cpu->idle->writes++))
+#define SPIN_CHECK(end) if (cpu->idle && spinCheck(cpu, PC, (end))) goto spinning
+
+#else
+
+#define SPIN_WRITE() ((void)0)
+#define SPIN_CHECK(end)
+
+#endif
+
+/*
+  Traps :
+
+  Built with PUCE6502_TRAPS and given cpu->traps, the core hands the routines
+  starting at the trapped addresses to the user instead of running them, while
+  their page is marked mapped (the ROM they are in, not what may replace it).
+  The user's function does at once all the routine would, its RTS included,
+  and gives its cycles : busy-waits like the monitor's WAIT cost nothing but
+  the ticks they add, and not even these when skip is set, for runs that are
+  not paced. It may also decline, the routine then runs as usual : it is told
+  the cycles left to the run, that one taking longer would end late.
+*/
+
+#ifdef PUCE6502_TRAPS
+
+// the trapped routine at PC, if any, done : true if it was
+static inline int trapRun(puce6502_t *cpu, unsigned long long int left, unsigned int *cycles) {
+	puce6502_traps_t *traps = cpu->traps;
+	for (int i = 0; i < traps->count; i++)
+		if (traps->trap[i].address == PC) {
+			unsigned int taken = traps->trap[i].run(cpu, left);
+			if (taken && !traps->skip)
+				*cycles = taken;
+			return taken != 0;
+		}
+	return 0;
+}
 
-void puce6502RST() {  // Reset
+#define TRAPPED(pc) (cpu->traps && cpu->traps->mapped[(pc) >> 8])  // maybe trapped
+#define TRAP() if (TRAPPED(PC) && trapRun(cpu, cycleCount - ticks, &cycles)) goto trapped
+
+#else
+
+#define TRAPPED(pc) 0
+#define TRAP()
+
+#endif
+
+#ifdef PUCE6502_CACHE
+
+// bytes used by each instruction, 0 for the ones ending a block : jumps,
+// branches, returns, BRK, WAI, STP and the undefined opcodes
+#define ENDS_BLOCK(mnemonic, mode) (mode == REL || mode == ZPR || mnemonic == JMP || mnemonic == JSR \
+	|| mnemonic == RTS || mnemonic == RTI || mnemonic == BRK || mnemonic == WAI || mnemonic == STP)
+#define INSN_LENGTH(opcode, mnemonic, mode, clocks, cross, cpus) \
+	ON_##cpus([opcode] = ENDS_BLOCK(mnemonic, mode) ? 0 : LENGTH(mode),)
+
+static const uint8_t insnLength[256] = { PUCE6502_OPCODES(INSN_LENGTH) };
+
+#endif
+
+#ifdef PUCE6502_JIT
+#include "puce6502jit.h"
+#endif
+
+#include "puce6502cache.h"
+
+#ifdef PUCE6502_CMOS
+typedef enum {run, step, stop, wait} status;
+#define DECIMAL_CYCLES 1
+#define CPU_ID 0x65C02
+#else
+#define DECIMAL_CYCLES 0
+#define CPU_ID 0x6502
+#endif
+
+/*
+  Bus accesses :
+
+  By default an instruction makes all its accesses at once and ticks moves on
+  by its whole cycle count afterwards. Built with PUCE6502_CYCLE_EXACT, ticks
+  moves on by one before each access instead, so the machine sees the cycle
+  the access happens on (speaker clicks, floating bus), and the cycles with
+  nothing to do make their dummy accesses as the CPU does : operand or stack
+  reads, the page crossing read of the indexed modes and the dummy write (NMOS)
+  or read (65C02) of read-modify-write instructions. The instruction's total
+  still comes from the opcode table.
+*/
+
+#ifdef PUCE6502_CYCLE_EXACT
+
+	#ifdef PUCE6502_JIT
+		#error "PUCE6502_JIT does not time the bus accesses"
+	#endif
+
+	#define BUS(access) (ticks++, access)  // one cycle each
+	#define IDLE(address) ((void)BUS(readMem(address)))  // dummy read
+	#ifdef PUCE6502_CMOS
+		#define IDLE_INDEXED(unfixed) IDLE(PC - 1)  // the last operand byte again
+		#define IDLE_MODIFY(value) IDLE(address)
+	#else
+		#define IDLE_INDEXED(unfixed) IDLE(unfixed)  // before the high byte is fixed
+		#define IDLE_MODIFY(value) BUS(writeMem(address, (value)))  // the value read, written back
+	#endif
+	#define CYCLES_DONE() (ticks = begin += cycles)  // the cycles the accesses did not take
+	#define INSN_TICKS begin
+
+#else
+
+	#define BUS(access) (access)
+	#define IDLE(address) ((void)0)
+	#define IDLE_INDEXED(unfixed) ((void)0)
+	#define IDLE_MODIFY(value) ((void)0)
+	#define CYCLES_DONE() (ticks += cycles)
+	#define INSN_TICKS ticks
+
+#endif
+
+#define BUS_READ(address)         BUS(readMem(address))
+#define BUS_WRITE(address, value) (SPIN_WRITE(), BUS(writeMem(address, (value))))
+#define BUS_FETCH(address)        BUS(FETCH(address))
+
+#ifdef PUCE6502_TRACE
+
+#ifdef PUCE6502_JIT
+	#error "PUCE6502_JIT does not trace the host code it runs"
+#endif
+
+// the instruction whose opcode was just fetched, into the user's ring
+static inline void traceRecord(puce6502_t *cpu, uint8_t opcode, uint8_t operand1, uint8_t operand2, unsigned long long int start) {
+	puce6502_trace_t *trace = cpu->trace;
+	puce6502_record_t *record = &trace->records[trace->count & (PUCE6502_TRACE_SIZE - 1)];
+
+	record->cycle = start;
+	record->pc = PC - 1;
+	record->bytes[0] = opcode;
+	record->bytes[1] = operand1;
+	record->bytes[2] = operand2;
+	record->a = A;
+	record->x = X;
+	record->y = Y;
+	record->sp = SP;
+	record->p = GET_P();
+
+	trace->count++;
+	if (record->pc == trace->trigger && !trace->stopAt)
+		trace->stopAt = trace->count + trace->after;
+	if (trace->count == trace->stopAt)
+		trace->stopped = 1;
+}
+
+// operands are read the way the instruction reads them, no access is timed
+#define TRACE(opcode, mode) \
+	if (cpu->trace && !cpu->trace->stopped) \
+		traceRecord(cpu, opcode, LENGTH(mode) > 1 ? FETCH(PC) : 0, LENGTH(mode) > 2 ? FETCH(PC + 1) : 0, INSN_TICKS)
+
+#else
+
+#define TRACE(opcode, mode)
+
+#endif
+
+#ifdef PUCE6502_PROFILE
+
+#ifdef PUCE6502_JIT
+	#error "PUCE6502_JIT does not count the host code it runs"
+#endif
+
+// an instruction ran at address
+static inline void profileCount(puce6502_t *cpu, uint16_t address, unsigned int spent) {
+	puce6502_profile_t *profile = cpu->profile;
+	uint8_t bank = profile->bank[address >> 8] & (PUCE6502_PROFILE_BANKS - 1);
+
+	profile->instructions[bank][address]++;
+	profile->cycles[bank][address] += spent;
+	profile->tree[profile->node].instructions++;
+	profile->tree[profile->node].cycles += spent;
+}
+
+// leaves the subroutines whose JSR the stack pointer went back over : RTS,
+// RTI, but also return addresses pulled or dropped by TXS
+static inline void profileUnwind(puce6502_profile_t *profile, uint8_t sp) {
+	while (profile->depth && profile->frames[profile->depth - 1].sp <= sp)
+		profile->node = profile->frames[--profile->depth].node;
+}
+
+// a JSR just ran, PC is the subroutine
+static void profileCall(puce6502_t *cpu) {
+	puce6502_profile_t *profile = cpu->profile;
+	puce6502_node_t *tree = profile->tree;
+	uint32_t address = (profile->bank[PC >> 8] & (PUCE6502_PROFILE_BANKS - 1)) << 16 | PC;
+	uint32_t child;
+
+	profileUnwind(profile, SP + 2);
+	if (profile->depth == PUCE6502_PROFILE_DEPTH)
+		return;  // too deep, counted in the caller
+
+	if (!profile->nodes)
+		profile->nodes = 1;  // the root
+	for (child = tree[profile->node].child; child && tree[child].address != address; child = tree[child].sibling);
+	if (!child) {
+		if (profile->nodes == PUCE6502_PROFILE_NODES)
+			return;  // tree full, counted in the caller
+		child = profile->nodes++;
+		tree[child] = (puce6502_node_t){ address, profile->node, 0, tree[profile->node].child, 0, 0 };
+		tree[profile->node].child = child;
+	}
+
+	profile->frames[profile->depth].node = profile->node;
+	profile->frames[profile->depth].sp = SP + 2;
+	profile->depth++;
+	profile->node = child;
+}
+
+// insnPC is the address of the instruction being run
+#define PROFILE_START() insnPC = PC - 1
+#define PROFILE_DONE(mnemonic) \
+	if (cpu->profile) { \
+		profileCount(cpu, insnPC, cycles); \
+		if (mnemonic == JSR) \
+			profileCall(cpu); \
+		else if (mnemonic == RTS || mnemonic == RTI) \
+			profileUnwind(cpu->profile, SP); \
+	}
+
+#else
+
+#define PROFILE_START()
+#define PROFILE_DONE(mnemonic)
+
+#endif
+
+#ifdef PUCE6502_STATS
+
+#ifdef PUCE6502_JIT
+	#error "PUCE6502_JIT does not count the host code it runs"
+#endif
+
+// insnStats gathers the events of the instruction being run
+#define STATS_CROSSED 1
+#define STATS_TAKEN   2
+#define STATS_START()       insnStats = 0
+#define STATS_EVENT(event)  insnStats |= (event)
+#define STATS_DONE(opcode) \
+	if (cpu->stats) { \
+		cpu->stats->runs[opcode]++; \
+		cpu->stats->cycles[opcode] += cycles; \
+		cpu->stats->crossed[opcode] += insnStats & STATS_CROSSED; \
+		cpu->stats->taken[opcode] += insnStats >> 1; \
+	}
+
+#else
+
+#define STATS_START()
+#define STATS_EVENT(event)
+#define STATS_DONE(opcode)
+
+#endif
+
+// decimal mode ADC and SBC, indexed by C << 16 | A << 8 | operand : the
+// low byte is the result, then the flags below. Built by puce6502Init(), read
+// only afterwards : all the CPUs share them.
+#define DECIMAL_C  0x0100
+#define DECIMAL_V  0x0200
+#define DECIMAL_NZ 0x0400  // not zero
+#define DECIMAL_N  0x8000
+
+static uint16_t decimalADC[0x20000], decimalSBC[0x20000];
+
+void puce6502Init(void) {
+	for (int i = 0; i < 0x20000; i++) {
+		int c = i >> 16, a = (i >> 8) & 0xFF, b = i & 0xFF;
+		int bin, res, lo, hi, n, v;
+
+		// ADC, the nibbles are adjusted one after the other
+		bin = a + b + c;
+		lo = (a & 0x0F) + (b & 0x0F) + c;
+		if (lo > 0x09)
+			lo = ((lo + 0x06) & 0x0F) + 0x10;
+		res = (a & 0xF0) + (b & 0xF0) + lo;
+		hi = (int8_t)(a & 0xF0) + (int8_t)(b & 0xF0) + lo;
+		v = hi < -128 || hi > 127;  // before the high nibble is adjusted
+		n = res & SIGN;
+		if (res > 0x9F)
+			res += 0x60;
+#ifdef PUCE6502_CMOS
+		bin = res;  // N and Z of the decimal result
+		n = res & SIGN;
+#endif
+		decimalADC[i] = (res & 0xFF) | (res > 0xFF ? DECIMAL_C : 0) | (v ? DECIMAL_V : 0)
+			| (bin & 0xFF ? DECIMAL_NZ : 0) | (n ? DECIMAL_N : 0);
+
+		// SBC, C and V always come from the binary subtraction
+		bin = a - b - !c;
+		lo = (a & 0x0F) - (b & 0x0F) - !c;
+#ifdef PUCE6502_CMOS
+		res = bin;
+		if (res < 0)
+			res -= 0x60;
+		if (lo < 0)
+			res -= 0x06;
+		n = res & SIGN;
+		v = ((a ^ b) & (a ^ bin) & SIGN) != 0;
+		decimalSBC[i] = (res & 0xFF) | (bin >= 0 ? DECIMAL_C : 0) | (v ? DECIMAL_V : 0)
+			| (res & 0xFF ? DECIMAL_NZ : 0) | (n ? DECIMAL_N : 0);
+#else
+		if (lo < 0)
+			lo = ((lo - 0x06) & 0x0F) - 0x10;
+		res = (a & 0xF0) - (b & 0xF0) + lo;
+		if (res < 0)
+			res -= 0x60;
+		v = ((a ^ b) & (a ^ bin) & SIGN) != 0;
+		decimalSBC[i] = (res & 0xFF) | (bin >= 0 ? DECIMAL_C : 0) | (v ? DECIMAL_V : 0)
+			| (bin & 0xFF ? DECIMAL_NZ : 0) | (bin & SIGN ? DECIMAL_N : 0);
+#endif
+	}
+}
+
+
+void puce6502RST(puce6502_t *cpu) {  // Reset
 	PC = readMem(0xFFFC) | (readMem(0xFFFD) << 8);
 	SP = 0xFD;
 	P.I = 1;
 	P.U = 1;
+#ifdef PUCE6502_CMOS
+	state = run;
+#endif
 	ticks += 7;
 }
 
 
-void puce6502IRQ() {  // Interupt Request
+void puce6502IRQ(puce6502_t *cpu) {  // Interupt Request
+#ifdef PUCE6502_CMOS
+	state = run;  // always ?
+#endif
 	if (!P.I) return;
+	unsigned long long int begin = ticks;
 	P.I = 1;
+	IDLE(PC);
+	IDLE(PC);
 	PC++;
-	writeMem(0x100 + SP, (PC >> 8) & 0xFF);
+	BUS_WRITE(0x100 + SP, (PC >> 8) & 0xFF);
 	SP--;
-	writeMem(0x100 + SP, PC & 0xFF);
+	BUS_WRITE(0x100 + SP, PC & 0xFF);
 	SP--;
-	writeMem(0x100 + SP, P.byte & ~BREAK);
+	BUS_WRITE(0x100 + SP, GET_P() & ~BREAK);
 	SP--;
-	PC = readMem(0xFFFE) | (readMem(0xFFFF) << 8);
-	ticks += 7;
+	PC = BUS_READ(0xFFFE);
+	PC |= BUS_READ(0xFFFF) << 8;
+	ticks = begin + 7;
 }
 
 
-void puce6502NMI() {  // Non Maskable Interupt
+void puce6502NMI(puce6502_t *cpu) {  // Non Maskable Interupt
+#ifdef PUCE6502_CMOS
+	state = run;
+#endif
+	unsigned long long int begin = ticks;
 	P.I = 1;
+	IDLE(PC);
+	IDLE(PC);
 	PC++;
-	writeMem(0x100 + SP, (PC >> 8) & 0xFF);
+	BUS_WRITE(0x100 + SP, (PC >> 8) & 0xFF);
 	SP--;
-	writeMem(0x100 + SP, PC & 0xFF);
+	BUS_WRITE(0x100 + SP, PC & 0xFF);
 	SP--;
-	writeMem(0x100 + SP, P.byte & ~BREAK);
+	BUS_WRITE(0x100 + SP, GET_P() & ~BREAK);
 	SP--;
-	PC = readMem(0xFFFA) | (readMem(0xFFFB) << 8);
-	ticks += 7;
+	PC = BUS_READ(0xFFFA);
+	PC |= BUS_READ(0xFFFB) << 8;
+	ticks = begin + 7;
 }
 
 
 /*
-  Addressing modes abreviations used in the comments down below :
-
-  IMP	: Implied or Implicit : DEX, RTS, CLC - 25 instructions
-  ACC	: Accumulator : ASL A, ROR A, DEC A - 4 instructions
-  IMM	: Immediate : LDA #$A5 - 11
-  ZPG	: Zero Page : LDA $81 - 21 instructions
-  ZPX	: Zero Page Indexed with X : LDA $55,X - 16 instructions
-  ZPY	: Zero Page Indexed with Y : LDX $55,Y - 2 instructions
-  REL	: Relative : BEQ LABEL12 - 8 instructions
-  ABS	: Absolute : LDA $2000 - 23 instructions
-  ABX	: Absolute Indexed with X : LDA $2000,X - 15 instructions
-  ABY	: Absolute Indexed with Y : LDA $2000,Y - 9 instructions
-  IND	: Indirect : JMP ($1020) - 1 instruction
-  IZX	: ZP Indexed Indirect with X (Preindexed) : LDA ($55,X) - 8 instructions
-  IZY	: ZP Indirect Indexed with Y (Postindexed) : LDA ($55),Y - 8 instructions
+  Addressing modes abreviations used in the opcode table :
+
+  IMP	: Implied or Implicit : DEX, RTS, CLC
+  ACC	: Accumulator : ASL A, ROR A, DEC A
+  IMM	: Immediate : LDA #$A5
+  ZPG	: Zero Page : LDA $81
+  ZPX	: Zero Page Indexed with X : LDA $55,X
+  ZPY	: Zero Page Indexed with Y : LDX $55,Y
+  REL	: Relative : BEQ LABEL12
+  IZP	: Indirect Zero Page : LDA ($55) (65C02 only)
+  IZX	: ZP Indexed Indirect with X (Preindexed) : LDA ($55,X)
+  IZY	: ZP Indirect Indexed with Y (Postindexed) : LDA ($55),Y
+  ABS	: Absolute : LDA $2000
+  ABX	: Absolute Indexed with X : LDA $2000,X
+  ABY	: Absolute Indexed with Y : LDA $2000,Y
+  IND	: Indirect : JMP ($1020)
+  IAX	: Absolute Indexed Indirect : JMP ($2000,X) (65C02 only)
+  ZPR	: Zero Page Relative : BBS0 $23, LABEL (65C02 only)
  */
 
-uint16_t puce6502Exec(unsigned long long int cycleCount)
-{
-	cycleCount += ticks;	// cycleCount becomes the targeted ticks value
-	while (ticks < cycleCount)
-		ticks += puce6502Step();
-	return PC;
-}
+// operand address of each mode, plus a cycle if cross and indexing crosses a page
+#define EA_IMP(cross)
+#define EA_ACC(cross)
+#define EA_IMM(cross) address = PC; PC++
+#define EA_ZPG(cross) address = BUS_FETCH(PC); PC++
+#define EA_ZPX(cross) address = BUS_FETCH(PC); PC++; IDLE(address); address = (address + X) & 0xFF
+#define EA_ZPY(cross) address = BUS_FETCH(PC); PC++; IDLE(address); address = (address + Y) & 0xFF
+#define EA_IZP(cross) value8 = BUS_FETCH(PC); PC++; address = BUS_READ(value8); value8++; address |= BUS_READ(value8) << 8
+#define EA_IZX(cross) value8 = BUS_FETCH(PC); PC++; IDLE(value8); value8 += X; address = BUS_READ(value8); value8++; address |= BUS_READ(value8) << 8
+#define EA_IZY(cross) EA_IZP(cross); CROSS(Y, cross); address += Y
+#define EA_ABS(cross) address = BUS_FETCH(PC); PC++; address |= BUS_FETCH(PC) << 8; PC++
+#define EA_ABX(cross) EA_ABS(cross); CROSS(X, cross); address += X
+#define EA_ABY(cross) EA_ABS(cross); CROSS(Y, cross); address += Y
+#define EA_IND(cross) EA_ABS(cross); value16 = BUS_READ(address); address = value16 | BUS_READ(address + 1) << 8
+#define EA_IAX(cross) EA_ABX(cross); value16 = BUS_READ(address); address = value16 | BUS_READ(address + 1) << 8
+
+// the writes and read-modify-writes always take the fix up cycle, cross is 0 for them
+#define CROSS(index, cross) \
+	if (!(cross) || (((address & 0xFF) + (index)) & 0xFF00)) { \
+		if (cross) { \
+			cycles++; \
+			STATS_EVENT(STATS_CROSSED); \
+		} \
+		IDLE_INDEXED((address & 0xFF00) | ((address + (index)) & 0xFF)); \
+	}
+
+// the operand, immediate operands are part of the instruction
+#define READ(mode)         (mode == ACC ? A : mode == IMM ? BUS_FETCH(address) : BUS_READ(address))
+#define WRITE(mode, value) if (mode == ACC) A = (value); else BUS_WRITE(address, (value))
+
+#define PUSH(value) BUS_WRITE(0x100 + SP, (value)); SP--
+#define PULL()      (SP++, BUS_READ(0x100 + SP))
+
+#define BIT_OF(opcode) (1 << (((opcode) >> 4) & 7))  // RMB, SMB, BBR and BBS
+
+#define LOAD(reg, mode, cross)    EA_##mode(cross); reg = READ(mode); NZ = reg
+#define STORE(value, mode, cross) EA_##mode(cross); BUS_WRITE(address, (value))
+
+#define COMPARE(reg, mode, cross) \
+	EA_##mode(cross); \
+	value8 = READ(mode); \
+	NZ = (reg - value8) & 0xFF; \
+	P.C = reg >= value8
+
+// read, modify and write back value8
+#define MODIFY(mode, cross, operation) \
+	EA_##mode(cross); \
+	value8 = READ(mode); \
+	if (mode != ACC) \
+		IDLE_MODIFY(value8); \
+	operation; \
+	WRITE(mode, value8); \
+	NZ = value8
+
+// A + value8 + C, SBC complements value8 first
+#define ADD() \
+	value16 = A + value8 + P.C; \
+	P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0; \
+	P.C = value16 > 0xFF; \
+	A = value16 & 0xFF; \
+	NZ = A
+
+// A and value8 through a decimal table, the 65C02 takes one more cycle
+#define DECIMAL(table) \
+	value16 = table[P.C << 16 | A << 8 | value8]; \
+	A = value16 & 0xFF; \
+	P.C = (value16 & DECIMAL_C) != 0; \
+	P.V = (value16 & DECIMAL_V) != 0; \
+	NZ = (value16 & DECIMAL_N) >> 7 | (value16 & DECIMAL_NZ) >> 10; \
+	cycles += DECIMAL_CYCLES
+
+#define BRANCH(condition) \
+	address = BUS_FETCH(PC); \
+	PC++; \
+	if (condition) {  /* branch taken */ \
+		cycles++; \
+		STATS_EVENT(STATS_TAKEN); \
+		IDLE(PC); \
+		if (address & SIGN) \
+			address |= 0xFF00;  /* jump backward */ \
+		if (((PC & 0xFF) + address) & 0xFF00) {  /* page crossing */ \
+			cycles++; \
+			STATS_EVENT(STATS_CROSSED); \
+			IDLE((PC & 0xFF00) | ((PC + address) & 0xFF)); \
+		} \
+		PC += address; \
+		if (address & SIGN) \
+			SPIN_CHECK(PC - address); \
+	}
+
+#define BIT_BRANCH(condition) \
+	address = BUS_FETCH(PC); \
+	PC++; \
+	value8 = BUS_READ(address); \
+	IDLE(address); \
+	address = BUS_FETCH(PC); \
+	PC++; \
+	if (address & SIGN) \
+		address |= 0xFF00;  /* jump backward */ \
+	if (condition) { \
+		STATS_EVENT(STATS_TAKEN); \
+		PC += address; \
+	}
+
+// the instructions, for the mnemonics of the opcode table
+#define DO_ADC(mode, cross, opcode) \
+	EA_##mode(cross); \
+	value8 = READ(mode); \
+	if (P.D) { \
+		DECIMAL(decimalADC); \
+	} else { \
+		ADD(); \
+	}
+#define DO_AND(mode, cross, opcode) EA_##mode(cross); A &= READ(mode); NZ = A
+#define DO_ASL(mode, cross, opcode) MODIFY(mode, cross, P.C = value8 >> 7; value8 <<= 1)
+#define DO_BBR(mode, cross, opcode) BIT_BRANCH(!(value8 & BIT_OF(opcode)))
+#define DO_BBS(mode, cross, opcode) BIT_BRANCH(value8 & BIT_OF(opcode))
+#define DO_BCC(mode, cross, opcode) BRANCH(!P.C)
+#define DO_BCS(mode, cross, opcode) BRANCH(P.C)
+#define DO_BEQ(mode, cross, opcode) BRANCH(FLAG_Z)
+#define DO_BIT(mode, cross, opcode) \
+	EA_##mode(cross); \
+	value8 = READ(mode); \
+	if (mode == IMM) \
+		SET_Z(A & value8);  /* 65C02, Z alone */ \
+	else { \
+		NZ = (value8 & SIGN) << 1 | ((A & value8) != 0); \
+		P.V = (value8 & OFLOW) != 0; \
+	}
+#define DO_BMI(mode, cross, opcode) BRANCH(FLAG_N)
+#define DO_BNE(mode, cross, opcode) BRANCH(!FLAG_Z)
+#define DO_BPL(mode, cross, opcode) BRANCH(!FLAG_N)
+#define DO_BRA(mode, cross, opcode) BRANCH(1)
+#define DO_BRK(mode, cross, opcode) \
+	PC++; \
+	PUSH(PC >> 8); \
+	PUSH(PC & 0xFF); \
+	PUSH(GET_P() | BREAK); \
+	P.I = 1; \
+	P.D = 0; \
+	PC = BUS_READ(0xFFFE); \
+	PC |= BUS_READ(0xFFFF) << 8
+#define DO_BVC(mode, cross, opcode) BRANCH(!P.V)
+#define DO_BVS(mode, cross, opcode) BRANCH(P.V)
+#define DO_CLC(mode, cross, opcode) P.C = 0
+#define DO_CLD(mode, cross, opcode) P.D = 0
+#define DO_CLI(mode, cross, opcode) P.I = 0
+#define DO_CLV(mode, cross, opcode) P.V = 0
+#define DO_CMP(mode, cross, opcode) COMPARE(A, mode, cross)
+#define DO_CPX(mode, cross, opcode) COMPARE(X, mode, cross)
+#define DO_CPY(mode, cross, opcode) COMPARE(Y, mode, cross)
+#define DO_DEC(mode, cross, opcode) MODIFY(mode, cross, value8--)
+#define DO_DEX(mode, cross, opcode) X--; NZ = X
+#define DO_DEY(mode, cross, opcode) Y--; NZ = Y
+#define DO_EOR(mode, cross, opcode) EA_##mode(cross); A ^= READ(mode); NZ = A
+#define DO_INC(mode, cross, opcode) MODIFY(mode, cross, value8++)
+#define DO_INX(mode, cross, opcode) X++; NZ = X
+#define DO_INY(mode, cross, opcode) Y++; NZ = Y
+#define DO_JMP(mode, cross, opcode) EA_##mode(cross); PC = address
+#define DO_JSR(mode, cross, opcode) \
+	address = BUS_FETCH(PC); \
+	PC++; \
+	IDLE(0x100 + SP); \
+	PUSH(PC >> 8);  /* the address of the last byte of JSR */ \
+	PUSH(PC & 0xFF); \
+	address |= BUS_FETCH(PC) << 8; \
+	PC = address
+#define DO_LDA(mode, cross, opcode) LOAD(A, mode, cross)
+#define DO_LDX(mode, cross, opcode) LOAD(X, mode, cross)
+#define DO_LDY(mode, cross, opcode) LOAD(Y, mode, cross)
+#define DO_LSR(mode, cross, opcode) MODIFY(mode, cross, P.C = value8 & 1; value8 >>= 1)
+#define DO_NOP(mode, cross, opcode) PC += LENGTH(mode) - 1
+#define DO_ORA(mode, cross, opcode) EA_##mode(cross); A |= READ(mode); NZ = A
+#define DO_PHA(mode, cross, opcode) PUSH(A)
+#define DO_PHP(mode, cross, opcode) PUSH(GET_P() | BREAK)
+#define DO_PHX(mode, cross, opcode) PUSH(X)
+#define DO_PHY(mode, cross, opcode) PUSH(Y)
+#define DO_PLA(mode, cross, opcode) IDLE(0x100 + SP); A = PULL(); NZ = A
+#define DO_PLP(mode, cross, opcode) IDLE(0x100 + SP); SET_P(PULL() | UNDEF)
+#define DO_PLX(mode, cross, opcode) IDLE(0x100 + SP); X = PULL(); NZ = X
+#define DO_PLY(mode, cross, opcode) IDLE(0x100 + SP); Y = PULL(); NZ = Y
+#define DO_RMB(mode, cross, opcode) EA_##mode(cross); value8 = BUS_READ(address); IDLE_MODIFY(value8); BUS_WRITE(address, value8 & ~BIT_OF(opcode))
+#define DO_ROL(mode, cross, opcode) MODIFY(mode, cross, value16 = value8 << 1 | P.C; P.C = value16 > 0xFF; value8 = value16)
+#define DO_ROR(mode, cross, opcode) MODIFY(mode, cross, value16 = value8 >> 1 | P.C << 7; P.C = value8 & 1; value8 = value16)
+#define DO_RTI(mode, cross, opcode) IDLE(0x100 + SP); SET_P(PULL()); PC = PULL(); PC |= PULL() << 8
+#define DO_RTS(mode, cross, opcode) IDLE(0x100 + SP); PC = PULL(); PC |= PULL() << 8; IDLE(PC); PC++
+#define DO_SBC(mode, cross, opcode) \
+	EA_##mode(cross); \
+	value8 = READ(mode); \
+	if (P.D) { \
+		DECIMAL(decimalSBC); \
+	} else { \
+		value8 ^= 0xFF; \
+		ADD(); \
+	}
+#define DO_SEC(mode, cross, opcode) P.C = 1
+#define DO_SED(mode, cross, opcode) P.D = 1
+#define DO_SEI(mode, cross, opcode) P.I = 1
+#define DO_SMB(mode, cross, opcode) EA_##mode(cross); value8 = BUS_READ(address); IDLE_MODIFY(value8); BUS_WRITE(address, value8 | BIT_OF(opcode))
+#define DO_STA(mode, cross, opcode) STORE(A, mode, cross)
+#define DO_STP(mode, cross, opcode) state = stop; goto halted
+#define DO_STX(mode, cross, opcode) STORE(X, mode, cross)
+#define DO_STY(mode, cross, opcode) STORE(Y, mode, cross)
+#define DO_STZ(mode, cross, opcode) STORE(0, mode, cross)
+#define DO_TAX(mode, cross, opcode) X = A; NZ = X
+#define DO_TAY(mode, cross, opcode) Y = A; NZ = Y
+#define DO_TRB(mode, cross, opcode) EA_##mode(cross); value8 = READ(mode); IDLE_MODIFY(value8); SET_Z(value8 & A); BUS_WRITE(address, value8 & ~A)
+#define DO_TSB(mode, cross, opcode) EA_##mode(cross); value8 = READ(mode); IDLE_MODIFY(value8); SET_Z(value8 & A); BUS_WRITE(address, value8 | A)
+#define DO_TSX(mode, cross, opcode) X = SP; NZ = X
+#define DO_TXA(mode, cross, opcode) A = X; NZ = A
+#define DO_TXS(mode, cross, opcode) SP = X
+#define DO_TYA(mode, cross, opcode) A = Y; NZ = A
+#define DO_WAI(mode, cross, opcode) state = wait; goto halted
+
+/*
+  Dispatch :
+
+  puce6502Exec() runs instructions until the cycle budget is consumed, without
+  going back to the caller between two instructions. With GCC and clang it uses
+  computed gotos : every opcode ends with its own indirect jump to the next one,
+  which the host branch predictor handles much better than the single jump of
+  a switch. Other compilers get the plain switch, define PUCE6502_NO_THREADED
+  to force it.
+*/
+
+#if defined(__GNUC__) && !defined(PUCE6502_NO_THREADED)
 
+	#define THREADED 1
+	#define DISPATCH goto *opcodes[BUS(FETCH_OPCODE())]
+	#define OPCODE(op) op_##op:
+	#define UNDEFINED op_undef:
+	#define LABEL(opcode, mnemonic, mode, clocks, cross, cpus) ON_##cpus([opcode] = &&op_##opcode,)
 
-unsigned int puce6502Step()
+#else
+
+	#define THREADED 0
+	#define DISPATCH goto dispatch
+	#define OPCODE(op) case op:
+	#define UNDEFINED default:
+
+#endif
+
+// account for the instruction just executed, then fetch the next one
+#define NEXT do { \
+	CYCLES_DONE(); \
+	cycles = 0; \
+	if (ticks >= cycleCount) \
+		return ticks - start; \
+	TRAP(); \
+	DISPATCH; \
+} while (0)
+
+// one opcode of the table, on the CPU being built
+#define EXECUTE(opcode, mnemonic, mode, clocks, cross, cpus) ON_##cpus( \
+	OPCODE(opcode) \
+		TRACE(opcode, mode); \
+		PROFILE_START(); \
+		STATS_START(); \
+		cycles += clocks; \
+		if ((mode == IMP || mode == ACC) && clocks > 1) \
+			IDLE(PC);  /* reads the next byte */ \
+		DO_##mnemonic(mode, cross, opcode); \
+		PROFILE_DONE(mnemonic); \
+		STATS_DONE(opcode); \
+	NEXT;)
+
+
+#if THREADED  // for puce6502Exec() only
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"  // labels as values
+	#pragma GCC diagnostic ignored "-Woverride-init"  // opcodes[] defaults to op_undef
+#endif
+
+unsigned long long int puce6502Exec(puce6502_t *cpu, unsigned long long int cycleCount)
 {
 	register uint16_t address;
 	register uint8_t  value8;
 	register uint16_t value16;
 
-	unsigned int cycles=0;
-
-	switch (readMem(PC++)) {  // fetch instruction and increment Program Counter
-
-		case 0x00 :  // IMP BRK
-			PC++;
-			writeMem(0x100 + SP, ((PC) >> 8) & 0xFF);
-			SP--;
-			writeMem(0x100 + SP, PC & 0xFF);
-			SP--;
-			writeMem(0x100 + SP, P.byte | BREAK);
-			SP--;
-			P.I = 1;
-			P.D = 0;
-			PC = readMem(0xFFFE) | (readMem(0xFFFF) << 8);
-			cycles += 7;
-		break;
-
-		case 0x01 :  // IZX ORA
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			A |= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x05 :  // ZPG ORA
-			A |= readMem(readMem(PC));
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0x06 :  // ZPG ASL
-			address = readMem(PC);
-			PC++;
-			value16 = readMem(address) << 1;
-			P.C = value16 > 0xFF;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0x08 :  // IMP PHP
-			writeMem(0x100 + SP, P.byte | BREAK);
-			SP--;
-			cycles += 3;
-		break;
-
-		case 0x09 :  // IMM ORA
-			A |= readMem(PC);
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x0A :  // ACC ASL
-			value16 = A << 1;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x0D :  // ABS ORA
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			A |= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x0E :  // ABS ASL
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value16 = readMem(address) << 1;
-			P.C = value16 > 0xFF;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x10 :  // REL BPL
-			address = readMem(PC);
-			PC++;
-			if (!P.S) {  // jump taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0x11 :  // IZY ORA
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			cycles += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-			address += Y;
-			A |= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x15 :  // ZPX ORA
-			A |= readMem(readMem(PC) + X);
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x16 :  // ZPX ASL
-			address = readMem(PC) + X;
-			PC++;
-			value16 = readMem(address) << 1;
-			writeMem(address, value16 & 0xFF);
-			P.C = value16 > 0xFF;
-			P.Z = value16 == 0;
-			P.S = (value16 & 0xFF) > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x18 :  // IMP CLC
-			P.C = 0;
-			cycles += 2;
-		break;
-
-		case 0x19 :  // ABY ORA
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			A |= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x1D :  // ABX ORA
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			A |= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x1E :  // ABX ASL
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value16 = readMem(address) << 1;
-			P.C = value16 > 0xFF;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 7;
-		break;
-
-		case 0x20 :  // ABS JSR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			writeMem(0x100 + SP, (PC >> 8) & 0xFF);
-			SP--;
-			writeMem(0x100 + SP, PC & 0xFF);
-			SP--;
-			PC = address;
-			cycles += 6;
-		break;
-
-		case 0x21 :  // IZX AND
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x24 :  // ZPG BIT
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			P.Z = (A & value8) == 0;
-			P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
-			cycles += 3;
-		break;
-
-		case 0x25 :  // ZPG AND
-			A &= readMem(readMem(PC));
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0x26 :  // ZPG ROL
-			address = readMem(PC);
-			PC++;
-			value16 = (readMem(address) << 1) | P.C;
-			P.C = (value16 & 0x100) != 0;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0x28 :  // IMP PLP
-			SP++;
-			P.byte = readMem(0x100 + SP) | UNDEF;
-			cycles += 4;
-		break;
-
-		case 0x29 :  // IMM AND
-			A &= readMem(PC);
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x2A :  // ACC ROL
-			value16 = (A << 1) | P.C;
-			P.C = (value16 & 0x100) != 0;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x2C :  // ABS BIT
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			P.Z = (A & value8) == 0;
-			P.byte = (P.byte & 0x3F) | (value8 & 0xC0);
-			cycles += 4;
-		break;
-
-		case 0x2D :  // ABS AND
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x2E :  // ABS ROL
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value16 = (readMem(address) << 1) | P.C;
-			P.C = (value16 & 0x100) != 0;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x30 :  // REL BMI
-			address = readMem(PC);
-			PC++;
-			if (P.S) {  // branch taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0x31 :  // IZY AND
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			cycles += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-			address += Y;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x35 :  // ZPX AND
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x36 :  // ZPX ROL
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value16 = (readMem(address) << 1) | P.C;
-			P.C = value16 > 0xFF;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x38 :  // IMP SEC
-			P.C = 1;
-			cycles += 2;
-		break;
-
-		case 0x39 :  // ABY AND
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x3D :  // ABX AND
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			A &= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x3E :  // ABX ROL
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value16 = (readMem(address) << 1) | P.C;
-			P.C = value16 > 0xFF;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 7;
-		break;
-
-		case 0x40 :  // IMP RTI
-			SP++;
-			P.byte = readMem(0x100 + SP);
-			SP++;
-			PC = readMem(0x100 + SP);
-			SP++;
-			PC |= readMem(0x100 + SP) << 8;
-			cycles += 6;
-		break;
-
-		case 0x41 :  // IZX EOR
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x45 :  // ZPG EOR
-			address = readMem(PC);
-			PC++;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0x46 :  // ZPG LSR
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			P.C = (value8 & 1) != 0;
-			value8 = value8 >> 1;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0x48 :  // IMP PHA
-			writeMem(0x100 + SP, A);
-			SP--;
-			cycles += 3;
-		break;
-
-		case 0x49 :  // IMM EOR
-			A ^= readMem(PC);
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x4A :  // ACC LSR
-			P.C = (A & 1) != 0;
-			A = A >> 1;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x4C :  // ABS JMP
-			PC = readMem(PC) | (readMem(PC + 1) << 8);
-			cycles += 3;
-		break;
-
-		case 0x4D :  // ABS EOR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x4E :  // ABS LSR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			P.C = (value8 & 1) != 0;
-			value8 = value8 >> 1;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x50 :  // REL BVC
-			address = readMem(PC);
-			PC++;
-			if (!P.V) {  // branch taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0x51 :  // IZY EOR
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			cycles += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-			A ^= readMem(address + Y);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x55 :  // ZPX EOR
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x56 :  // ZPX LSR
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			P.C = (value8 & 1) != 0;
-			value8 = value8 >> 1;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x58 :  // IMP CLI
-			P.I = 0;
-			cycles += 2;
-		break;
-
-		case 0x59 :  // ABY EOR
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x5D :  // ABX EOR
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			A ^= readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0x5E :  // ABX LSR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			P.C = (value8 & 1) != 0;
-			value8 = value8 >> 1;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 7;
-		break;
-
-		case 0x60 :  // IMP RTS
-			SP++;
-			PC = readMem(0x100 + SP);
-			SP++;
-			PC |= readMem(0x100 + SP) << 8;
-			PC++;
-			cycles += 6;
-		break;
-
-		case 0x61 :  // IZX ADC
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x65 :  // ZPG ADC
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0x66 :  // ZPG ROR
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			value16 = (value8 >> 1) | (P.C << 7);
-			P.C = (value8 & 0x1) != 0;
-			value16 &= 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0x68 :  // IMP PLA
-			SP++;
-			A = readMem(0x100 + SP);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x69 :  // IMM ADC
-			value8 = readMem(PC);
-			PC++;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x6A :  // ACC ROR
-			value16 = (A >> 1) | (P.C << 7);
-			P.C = (A & 0x1) != 0;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x6C :  // IND JMP
-			address = readMem(PC) | readMem(PC + 1) << 8;
-			PC = readMem(address) | (readMem(address + 1) << 8);
-			cycles += 5;
-		break;
-
-		case 0x6D :  // ABS ADC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x6E :  // ABS ROR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			value16 = (value8 >> 1) | (P.C << 7);
-			P.C = (value8 & 0x1) != 0;
-			value16 = value16 & 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x70 :  // REL BVS
-			address = readMem(PC);
-			PC++;
-			if (P.V) {  // branch taken
-				cycles++;
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0x71 :  // IZY ADC
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			if ((address + Y) & 0xFF00)  // page crossing
-				cycles++;
-			value8++;
-			address |= readMem(value8) << 8;
-			address += Y;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0x75 :  // ZPX ADC
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x76 :  // ZPX ROR
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			value16 = (value8 >> 1) | (P.C << 7);
-			P.C = (value8 & 0x1) != 0;
-			value16 = value16 & 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0x78 :  // IMP SEI
-			P.I = 1;
-			cycles += 2;
-		break;
-
-		case 0x79 :  // ABY ADC
-			if ((readMem(PC) + Y) & 0xFF00)
-				cycles++;
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x7D :  // ABX ADC
-			if ((readMem(PC) + X) & 0xFF00)
-				cycles++;
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0x7E :  // ABX ROR
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			value16 = (value8 >> 1) | (P.C << 7);
-			P.C = (value8 & 0x1) != 0;                          // TBR
-			value16 = value16 & 0xFF;
-			writeMem(address, value16);
-			P.Z = value16 == 0;
-			P.S = value16 > 0x7F;
-			cycles += 7;
-		break;
-
-		case 0x81 :  // IZX STA
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			writeMem(address, A);
-			cycles += 6;
-		break;
-
-		case 0x84 :  // ZPG STY
-			writeMem(readMem(PC), Y);
-			PC++;
-			cycles += 3;
-		break;
-
-		case 0x85 :  // ZPG STA
-			writeMem(readMem(PC), A);
-			PC++;
-			cycles += 3;
-		break;
-
-		case 0x86 :  // ZPG STX
-			writeMem(readMem(PC), X);
-			PC++;
-			cycles += 3;
-		break;
-
-		case 0x88 :  // IMP DEY
-			Y--;
-			P.Z = (Y & 0xFF) == 0;
-			P.S = (Y & SIGN) != 0;
-			cycles += 2;
-		break;
-
-		case 0x8A :  // IMP TXA
-			A = X;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x8C :  // ABS STY
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			writeMem(address, Y);
-			cycles += 4;
-		break;
-
-		case 0x8D :  // ABS STA
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			writeMem(address, A);
-			cycles += 4;
-		break;
-
-		case 0x8E :  // ABS STX
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			writeMem(address, X);
-			cycles += 4;
-		break;
-
-		case 0x90 :  // REL BCC
-			address = readMem(PC);
-			PC++;
-			if (!P.C) {  // branch taken
-				cycles++;
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0x91 :  // IZY STA
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			address += Y;
-			writeMem(address, A);
-			cycles += 6;
-		break;
-
-		case 0x94 :  // ZPX STY
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			writeMem(address, Y);
-			cycles += 4;
-		break;
-
-		case 0x95 :  // ZPX STA
-			writeMem((readMem(PC) + X) & 0xFF, A);
-			PC++;
-			cycles += 4;
-		break;
-
-		case 0x96 :  // ZPY STX
-			writeMem((readMem(PC) + Y) & 0xFF, X);
-			PC++;
-			cycles += 4;
-		break;
-
-		case 0x98 :  // IMP TYA
-			A = Y;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0x99 :  // ABY STA
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			writeMem(address, A);
-			cycles += 5;
-		break;
-
-		case 0x9A :  // IMP TXS
-			SP = X;
-			cycles += 2;
-		break;
-
-		case 0x9D :  // ABX STA
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			writeMem(address, A);
-			cycles += 5;
-		break;
-
-		case 0xA0 :  // IMM LDY
-			Y = readMem(PC);
-			PC++;
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xA1 :  // IZX LDA
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			A = readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0xA2 :  // IMM LDX
-			address = PC;
-			PC++;
-			X = readMem(address);
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xA4 :  // ZPG LDY
-			Y = readMem(readMem(PC));
-			PC++;
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0xA5 :  // ZPG LDA
-			A = readMem(readMem(PC));
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0xA6 :  // ZPG LDX
-			X = readMem(readMem(PC));
-			PC++;
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0xA8 :  // IMP TAY
-			Y = A;
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xA9 :  // IMM LDA
-			A = readMem(PC);
-			PC++;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xAA :  // IMP TAX
-			X = A;
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xAC :  // ABS LDY
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			Y = readMem(address);
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xAD :  // ABS LDA
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			A = readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xAE :  // ABS LDX
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			X = readMem(address);
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xB0 :  // REL BCS
-			address = readMem(PC);
-			PC++;
-			if (P.C) {  // branch taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0xB1 :  // IZY LDA
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			A = readMem(address + Y);
-			cycles += (((address & 0xFF) + Y) & 0xFF00) ? 6 : 5;  // page crossing
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0xB4 :  // ZPX LDY
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			Y = readMem(address);
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xB5 :  // ZPX LDA
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			A = readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xB6 :  // ZPY LDX
-			address = (readMem(PC) + Y) & 0xFF;
-			PC++;
-			X = readMem(address);
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xB8 :  // IMP CLV
-			P.V = 0;
-			cycles += 2;
-		break;
-
-		case 0xB9 :  // ABY LDA
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			A = readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0xBA :  // IMP TSX
-			X = SP;
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xBC :  // ABX LDY
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			Y = readMem(address);
-			P.Z = Y == 0;
-			P.S = Y > 0x7F;
-		break;
-
-		case 0xBD :  // ABX LDA
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			A = readMem(address);
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-		break;
-
-		case 0xBE :  // ABY LDX
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			X = readMem(address);
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-		break;
-
-		case 0xC0 :  // IMM CPY
-			value8 = readMem(PC);
-			PC++;
-			P.Z = ((Y - value8) & 0xFF) == 0;
-			P.S = ((Y - value8) & SIGN) != 0;
-			P.C = (Y >= value8) != 0;
-			cycles += 2;
-		break;
-
-		case 0xC1 :  // IZX CMP
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-			cycles += 6;
-		break;
-
-		case 0xC4 :  // ZPG CPY
-			value8 = readMem(readMem(PC));
-			PC++;
-			P.Z = ((Y - value8) & 0xFF) == 0;
-			P.S = ((Y - value8) & SIGN) != 0;
-			P.C = (Y >= value8) != 0;
-			cycles += 3;
-		break;
-
-		case 0xC5 :  // ZPG CMP
-			value8 = readMem(readMem(PC));
-			PC++;
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-			cycles += 3;
-		break;
-
-		case 0xC6 :  // ZPG DEC
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			--value8;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0xC8 :  // IMP INY
-			Y++;
-			P.Z = Y  == 0;
-			P.S = Y > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xC9 :  // IMM CMP
-			value8 = readMem(PC);
-			PC++;
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-			cycles += 2;
-		break;
-
-		case 0xCA :  // IMP DEX
-		  X--;
-			P.Z = (X & 0xFF) == 0;
-			P.S = X > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xCC :  // ABS CPY
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			P.Z = ((Y - value8) & 0xFF) == 0;
-			P.S = ((Y - value8) & SIGN) != 0;
-			P.C = (Y >= value8) != 0;
-			cycles += 4;
-		break;
-
-		case 0xCD :  // ABS CMP
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-			cycles += 4;
-		break;
-
-		case 0xCE :  // ABS DEC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			value8--;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0xD0 :  // REL BNE
-			address = readMem(PC);
-			PC++;
-			if (!P.Z) {  // branch taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0xD1 :  // IZY CMP
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			cycles += ((address + Y) & 0xFF00) ? 6 : 5;  // page crossing
-			value8++;
-			address |= readMem(value8) << 8;
-			address += Y;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-		break;
-
-		case 0xD5 :  // ZPX CMP
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-			cycles += 4;
-		break;
-
-		case 0xD6 :  // ZPX DEC
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			value8--;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0xD8 :  // IMP CLD
-			P.D = 0;
-			cycles += 2;
-		break;
-
-		case 0xD9 :  // ABY CMP
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + Y) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-		break;
-
-		case 0xDD :  // ABX CMP
-			address = readMem(PC);
-			PC++;
-			cycles += ((address + X) & 0xFF00) ? 5 : 4;  // page crossing
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			P.Z = ((A - value8) & 0xFF) == 0;
-			P.S = ((A - value8) & SIGN) != 0;
-			P.C = (A >= value8) != 0;
-		break;
-
-		case 0xDE :  // ABX DEC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			value8--;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = (value8 & SIGN) != 0;
-			cycles += 7;
-		break;
-
-		case 0xE0 :  // IMM CPX
-			value8 = readMem(PC);
-			PC++;
-			P.Z = ((X - value8) & 0xFF) == 0;
-			P.S = ((X - value8) & SIGN) != 0;
-			P.C = (X >= value8) != 0;
-			cycles += 2;
-		break;
-
-		case 0xE1 :  // IZX SBC
-			value8 = readMem(PC) + X;
-			PC++;
-			address = readMem(value8);
-			value8++;
-			address |= readMem(value8) << 8;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0xE4 :  // ZPG CPX
-			value8 = readMem(readMem(PC));
-			PC++;
-			P.Z = ((X - value8) & 0xFF) == 0;
-			P.S = ((X - value8) & SIGN) != 0;
-			P.C = (X >= value8) != 0;
-			cycles += 3;
-		break;
-
-		case 0xE5 :  // ZPG SBC
-			value8 = readMem(readMem(PC));
-			PC++;
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 3;
-		break;
-
-		case 0xE6 :  // ZPG INC
-			address = readMem(PC);
-			PC++;
-			value8 = readMem(address);
-			value8++;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0xE8 :  // IMP INX
-			X++;
-			P.Z = X == 0;
-			P.S = X > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xE9 :  // IMM SBC
-			value8 = readMem(PC);
-			PC++;
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + (P.C);
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 2;
-		break;
-
-		case 0xEA:  // IMP NOP
-			cycles += 2;
-		break;
-
-		case 0xEC :  // ABS CPX
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			P.Z = ((X - value8) & 0xFF) == 0;
-			P.S = ((X - value8) & SIGN) != 0;
-			P.C = (X >= value8) != 0;
-			cycles += 4;
-		break;
-
-		case 0xED :  // ABS SBC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xEE :  // ABS INC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			value8 = readMem(address);
-			value8++;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0xF0 :  // REL BEQ
-			address = readMem(PC);
-			PC++;
-			if (P.Z) {  // branch taken
-				cycles++;
-				if (address & SIGN)
-					address |= 0xFF00;  // jump backward
-				if (((PC & 0xFF) + address) & 0xFF00)  // page crossing
-					cycles++;
-				PC += address;
-			}
-			cycles += 2;
-		break;
-
-		case 0xF1 :  // IZY SBC
-			value8 = readMem(PC);
-			PC++;
-			address = readMem(value8);
-			if ((address + Y) & 0xFF00)  // page crossing
-				cycles++;
-			value8++;
-			address |= readMem(value8) << 8;
-			address += Y;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 5;
-		break;
-
-		case 0xF5 :  // ZPX SBC
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xF6 :  // ZPX INC
-			address = (readMem(PC) + X) & 0xFF;
-			PC++;
-			value8 = readMem(address);
-			value8++;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 6;
-		break;
-
-		case 0xF8 :  // IMP SED
-			P.D = 1;
-			cycles += 2;
-		break;
-
-		case 0xF9 :  // ABY SBC
-			address = readMem(PC);
-			PC++;
-			if ((address + Y) & 0xFF00)  // page crossing
-				cycles++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += Y;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C = value16 > 0xFF;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xFD :  // ABX SBC
-			address = readMem(PC);
-			PC++;
-			if ((address + X) & 0xFF00)  // page crossing
-				cycles++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			value8 ^= 0xFF;
-			if (P.D)
-				value8 -= 0x0066;
-			value16 = A + value8 + P.C;
-			P.V = ((value16 ^ A) & (value16 ^ value8) & 0x0080) != 0;
-			if (P.D)
-				value16 += ((((value16 + 0x66) ^ A ^ value8) >> 3) & 0x22) * 3;
-			P.C =  (value16 & 0xFF00) != 0;
-			A = value16 & 0xFF;
-			P.Z = A == 0;
-			P.S = A > 0x7F;
-			cycles += 4;
-		break;
-
-		case 0xFE :  // ABX INC
-			address = readMem(PC);
-			PC++;
-			address |= readMem(PC) << 8;
-			PC++;
-			address += X;
-			value8 = readMem(address);
-			value8++;
-			writeMem(address, value8);
-			P.Z = value8 == 0;
-			P.S = value8 > 0x7F;
-			cycles += 7;
-		break;
-
-		default:  // invalid / undocumented opcode
+	unsigned int cycles = 0;
+	unsigned long long int start = ticks;
+#ifdef PUCE6502_CYCLE_EXACT
+	unsigned long long int begin = ticks;  // of the current instruction
+#endif
+#ifdef PUCE6502_PROFILE
+	uint16_t insnPC = PC;
+#endif
+#ifdef PUCE6502_STATS
+	uint8_t insnStats = 0;
+#endif
+
+#ifdef PUCE6502_CACHE
+	const puce6502_block_t *block = NULL;  // block being run
+	const puce6502_insn_t *insn = NULL;  // its current instruction
+#endif
+
+	cycleCount += ticks;	// cycleCount becomes the targeted ticks value
+	if (ticks >= cycleCount)
+		return 0;
+
+#ifdef PUCE6502_CMOS
+	if (state != run && state != step)  // waiting for an interrupt or stopped
+		goto halted;
+#endif
+
+#if THREADED
+	static const void *const opcodes[256] = {
+		[0 ... 255] = &&op_undef,
+		PUCE6502_OPCODES(LABEL)
+	};
+	TRAP();
+	DISPATCH;
+#else
+	TRAP();
+	dispatch:
+	switch (BUS(FETCH_OPCODE()))
+#endif
+	{  // fetch instruction and increment Program Counter
+
+		PUCE6502_OPCODES(EXECUTE)
+
+		UNDEFINED  // invalid / undocumented opcode
+			TRACE(FETCH(PC - 1), IMP);
+			PROFILE_START();
+			STATS_START();
 			cycles += 2;  // as NOP
-		break;
-	}  // end of switch
+			IDLE(PC);
+			PROFILE_DONE(NOP);
+			STATS_DONE(FETCH(PC - 1));
+		NEXT;
+	}  // end of dispatch
+
+#ifdef PUCE6502_TRAPS
+	trapped:  // the user ran a routine in its place
+	NEXT;
+#endif
+
+#ifdef PUCE6502_CMOS
+	halted:  // WAI and STP : nothing happens until the next interrupt or reset
+	CYCLES_DONE();
+	if (ticks < cycleCount)
+		ticks += (cycleCount - ticks + 1) & ~1ULL;  // up to the budget, 2 cycles at a time
+	return ticks - start;
+#endif
+
+#ifdef PUCE6502_IDLE
+	spinning:  // waiting for a key, nothing changes until the budget ends
+	CYCLES_DONE();
+	if (ticks < cycleCount)
+		ticks = cycleCount;
+	return ticks - start;
+#endif
+}
+
+#if THREADED
+	#pragma GCC diagnostic pop
+#endif
 
+unsigned int puce6502Step(puce6502_t *cpu)
+{
+	unsigned int cycles = puce6502Exec(cpu, 1);  // a single instruction
+	ticks -= cycles;  // leaves the ticks update to the caller
 	return cycles;
 }
 
@@ -1839,69 +921,39 @@ unsigned int puce6502Step()
 // the code below was used during developpment for test and debug
 // and is not required for normal operation
 
-#include <stdio.h>
+#define MNEMONIC(opcode, mnemonic, mode, clocks, cross, cpus) ON_##cpus([opcode] = #mnemonic,)
+#define MODE(opcode, mnemonic, mode, clocks, cross, cpus)     ON_##cpus([opcode] = mode,)
+
+static const char* mn[256] = { PUCE6502_OPCODES(MNEMONIC) };  // NULL for the undefined opcodes
+static const uint8_t am[256] = { PUCE6502_OPCODES(MODE) };
 
-static const char* mn[256] = {
-	"BRK","ORA","UND","UND","UND","ORA","ASL","UND","PHP","ORA","ASL","UND","UND","ORA","ASL","UND",
-  "BPL","ORA","UND","UND","UND","ORA","ASL","UND","CLC","ORA","UND","UND","UND","ORA","ASL","UND",
-  "JSR","AND","UND","UND","BIT","AND","ROL","UND","PLP","AND","ROL","UND","BIT","AND","ROL","UND",
-  "BMI","AND","UND","UND","UND","AND","ROL","UND","SEC","AND","UND","UND","UND","AND","ROL","UND",
-  "RTI","EOR","UND","UND","UND","EOR","LSR","UND","PHA","EOR","LSR","UND","JMP","EOR","LSR","UND",
-  "BVC","EOR","UND","UND","UND","EOR","LSR","UND","CLI","EOR","UND","UND","UND","EOR","LSR","UND",
-  "RTS","ADC","UND","UND","UND","ADC","ROR","UND","PLA","ADC","ROR","UND","JMP","ADC","ROR","UND",
-  "BVS","ADC","UND","UND","UND","ADC","ROR","UND","SEI","ADC","UND","UND","UND","ADC","ROR","UND",
-  "UND","STA","UND","UND","STY","STA","STX","UND","DEY","UND","TXA","UND","STY","STA","STX","UND",
-  "BCC","STA","UND","UND","STY","STA","STX","UND","TYA","STA","TXS","UND","UND","STA","UND","UND",
-  "LDY","LDA","LDX","UND","LDY","LDA","LDX","UND","TAY","LDA","TAX","UND","LDY","LDA","LDX","UND",
-  "BCS","LDA","UND","UND","LDY","LDA","LDX","UND","CLV","LDA","TSX","UND","LDY","LDA","LDX","UND",
-  "CPY","CMP","UND","UND","CPY","CMP","DEC","UND","INY","CMP","DEX","UND","CPY","CMP","DEC","UND",
-  "BNE","CMP","UND","UND","UND","CMP","DEC","UND","CLD","CMP","UND","UND","UND","CMP","DEC","UND",
-  "CPX","SBC","UND","UND","CPX","SBC","INC","UND","INX","SBC","NOP","UND","CPX","SBC","INC","UND",
-  "BEQ","SBC","UND","UND","UND","SBC","INC","UND","SED","SBC","UND","UND","UND","SBC","INC","UND"
-};
-
-static const int am[256] = {
-   0x0 , 0xC , 0x0 , 0x0 , 0x0 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x1 , 0x0 , 0x0 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0 ,
-   0x7 , 0xC , 0x0 , 0x0 , 0x3 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x1 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0 ,
-   0x0 , 0xC , 0x0 , 0x0 , 0x0 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x1 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0 ,
-   0x0 , 0xC , 0x0 , 0x0 , 0x0 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x1 , 0x0 , 0xA , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0 ,
-   0x0 , 0xC , 0x0 , 0x0 , 0x3 , 0x3 , 0x3 , 0x0 , 0x0 , 0x0 , 0x0 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x4 , 0x4 , 0x5 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x0 , 0x0 ,
-   0x2 , 0xC , 0x2 , 0x0 , 0x3 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x0 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x4 , 0x4 , 0x5 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x8 , 0x8 , 0x9 , 0x0 ,
-   0x2 , 0xC , 0x0 , 0x0 , 0x3 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x0 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0 ,
-   0x2 , 0xC , 0x0 , 0x0 , 0x3 , 0x3 , 0x3 , 0x0 , 0x0 , 0x2 , 0x0 , 0x0 , 0x7 , 0x7 , 0x7 , 0x0 ,
-   0x6 , 0xD , 0x0 , 0x0 , 0x0 , 0x4 , 0x4 , 0x0 , 0x0 , 0x9 , 0x0 , 0x0 , 0x0 , 0x8 , 0x8 , 0x0
- };
-
-void dasm(uint16_t address, char *buffer) {
+void dasm(puce6502_t *cpu, uint16_t address, char *buffer) {
 
   uint8_t op = readMem(address);
   uint8_t b1 = readMem((address + 1) & 0xFFFF);
   uint8_t b2 = readMem((address + 2) & 0xFFFF);
+  const char *name = mn[op] ? mn[op] : "UND";
 
   sprintf(buffer, "%04X: [%02X %02X %02X] %02X", address, A, X, Y, op);
   buffer += strlen(buffer);
 
   switch(am[op]) {
-		case 0x0: sprintf(buffer, "       %s",					      mn[op]      ); break;  // implied
-		case 0x1: sprintf(buffer, "       %s A",				      mn[op]      ); break;  // accumulator
-		case 0x2: sprintf(buffer, "%02X     %s #$%02X",			b1,   mn[op],b1   ); break;  // immediate
-		case 0x3: sprintf(buffer, "%02X     %s $%02X",			b1,   mn[op],b1   ); break;  // zero page
-		case 0x4: sprintf(buffer, "%02X     %s $%02X,X",		b1,   mn[op],b1   ); break;  // zero page, X indexed
-		case 0x5: sprintf(buffer, "%02X     %s $%02X,Y",		b1,   mn[op],b1   ); break;  // zero page, Y indexed
-		case 0x6: sprintf(buffer, "%02X     %s $%02X",			b1,   mn[op],b1   ); break;  // relative
-		case 0xC: sprintf(buffer, "%02X     %s ($%02X,X)",		b1,   mn[op],b1   ); break;  // X indexed, indirect
-		case 0xD: sprintf(buffer, "%02X     %s ($%02X),Y",		b1,   mn[op],b1   ); break;  // indirect, Y indexed
-		case 0x7: sprintf(buffer, "%02X%02X   %s $%02X%02X",	b1,b2,mn[op],b2,b1); break;  // absolute
-		case 0x8: sprintf(buffer, "%02X%02X   %s $%02X%02X,X",	b1,b2,mn[op],b2,b1); break;  // absolute, X indexed
-		case 0x9: sprintf(buffer, "%02X%02X   %s $%02X%02X,Y",	b1,b2,mn[op],b2,b1); break;  // absolute, Y indexed
-		case 0xA: sprintf(buffer, "%02X%02X   %s ($%02X%02X)",	b1,b2,mn[op],b2,b1); break;  // indirect
+		case IMP: sprintf(buffer, "       %s",					      name        ); break;  // implied
+		case ACC: sprintf(buffer, "       %s A",				      name        ); break;  // accumulator
+		case IMM: sprintf(buffer, "%02X     %s #$%02X",			b1,   name,b1     ); break;  // immediate
+		case ZPG: sprintf(buffer, "%02X     %s $%02X",			b1,   name,b1     ); break;  // zero page
+		case ZPX: sprintf(buffer, "%02X     %s $%02X,X",		b1,   name,b1     ); break;  // zero page, X indexed
+		case ZPY: sprintf(buffer, "%02X     %s $%02X,Y",		b1,   name,b1     ); break;  // zero page, Y indexed
+		case REL: sprintf(buffer, "%02X     %s $%02X",			b1,   name,b1     ); break;  // relative
+		case IZP: sprintf(buffer, "%02X     %s ($%02X)",		b1,   name,b1     ); break;  // zero page, indirect
+		case IZX: sprintf(buffer, "%02X     %s ($%02X,X)",		b1,   name,b1     ); break;  // X indexed, indirect
+		case IZY: sprintf(buffer, "%02X     %s ($%02X),Y",		b1,   name,b1     ); break;  // indirect, Y indexed
+		case ABS: sprintf(buffer, "%02X%02X   %s $%02X%02X",	b1,b2,name,b2,b1  ); break;  // absolute
+		case ABX: sprintf(buffer, "%02X%02X   %s $%02X%02X,X",	b1,b2,name,b2,b1  ); break;  // absolute, X indexed
+		case ABY: sprintf(buffer, "%02X%02X   %s $%02X%02X,Y",	b1,b2,name,b2,b1  ); break;  // absolute, Y indexed
+		case IND: sprintf(buffer, "%02X%02X   %s ($%02X%02X)",	b1,b2,name,b2,b1  ); break;  // indirect
+		case IAX: sprintf(buffer, "%02X%02X   %s ($%02X%02X,X)",	b1,b2,name,b2,b1  ); break;  // X indexed, indirect
+		case ZPR: sprintf(buffer, "%02X%02X   %s $%02X,$%02X",	b1,b2,name,b1,b2  ); break;  // zero page, relative
   }
 }
 
@@ -1932,43 +984,236 @@ void dasm(uint16_t address) {
 }
 */
 
-void printRegs() {
+#ifdef PUCE6502_TRACE
+
+int puce6502TraceSave(puce6502_t *cpu, const char *filename) {
+	puce6502_trace_t *trace = cpu->trace;
+	if (!trace)
+		return 0;
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return 0;
+
+	uint32_t kept = trace->count < PUCE6502_TRACE_SIZE ? trace->count : PUCE6502_TRACE_SIZE;
+	uint32_t first = (trace->count - kept) & (PUCE6502_TRACE_SIZE - 1);  // the oldest record
+	uint32_t tail = kept < PUCE6502_TRACE_SIZE - first ? kept : PUCE6502_TRACE_SIZE - first;
+	puce6502_trace_header_t header = { PUCE6502_TRACE_MAGIC, CPU_ID, kept };
+
+	int ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(trace->records + first, sizeof(puce6502_record_t), tail, file) == tail
+		&& fwrite(trace->records, sizeof(puce6502_record_t), kept - tail, file) == kept - tail;
+	return fclose(file) == 0 && ok;
+}
+
+#else
+
+int puce6502TraceSave(puce6502_t *cpu, const char *filename) {
+	return 0;  // built without PUCE6502_TRACE
+}
+
+#endif
+
+#ifdef PUCE6502_PROFILE
+
+typedef struct {
+	uint64_t cycles, instructions;
+	uint32_t address;  // bank << 16 | address
+} spot_t;
+
+static int byCycles(const void *a, const void *b) {  // most first
+	uint64_t x = ((const spot_t *)a)->cycles, y = ((const spot_t *)b)->cycles;
+	return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static int byAddress(const void *a, const void *b) {
+	uint32_t x = ((const spot_t *)a)->address, y = ((const spot_t *)b)->address;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void profileName(char *buffer, uint32_t address) {
+	if (address >> 16)
+		sprintf(buffer, "%X:$%04X", address >> 16, address & 0xFFFF);  // bank
+	else
+		sprintf(buffer, "$%04X", address);
+}
+
+static void profileSpots(FILE *file, const char *title, spot_t *spots, size_t count, uint64_t total, int lines) {
+	char name[16];
+	qsort(spots, count, sizeof(spot_t), byCycles);
+	fprintf(file, "\n%s\n\n        cycles       %%   instructions  cyc/ins\n", title);
+	for (size_t i = 0; i < count && i < (size_t)lines; i++) {
+		profileName(name, spots[i].address);
+		fprintf(file, "%14llu  %6.2f %14llu  %7.2f  %s\n", (unsigned long long)spots[i].cycles,
+			100.0 * spots[i].cycles / total, (unsigned long long)spots[i].instructions,
+			(double)spots[i].cycles / spots[i].instructions, name);
+	}
+}
+
+int puce6502ProfileReport(puce6502_t *cpu, const char *filename, int lines) {
+	puce6502_profile_t *profile = cpu->profile;
+	if (!profile)
+		return 0;
+	uint32_t nodes = profile->nodes ? profile->nodes : 1;
+	spot_t *spots = malloc(sizeof(spot_t) * (PUCE6502_PROFILE_BANKS * 65536 > nodes ? PUCE6502_PROFILE_BANKS * 65536 : nodes));
+	FILE *file = spots ? fopen(filename, "w") : NULL;
+	if (!file) {
+		free(spots);
+		return 0;
+	}
+
+	size_t count = 0;
+	uint64_t total = 0;
+	for (uint32_t bank = 0; bank < PUCE6502_PROFILE_BANKS; bank++)
+		for (uint32_t address = 0; address < 65536; address++)
+			if (profile->instructions[bank][address]) {
+				spots[count++] = (spot_t){ profile->cycles[bank][address], profile->instructions[bank][address], bank << 16 | address };
+				total += profile->cycles[bank][address];
+			}
+	fprintf(file, "%llu cycles, %llu outside of any subroutine\n", (unsigned long long)total, (unsigned long long)profile->tree[0].cycles);
+	if (!total)
+		total = 1;
+	profileSpots(file, "instructions", spots, count, total, lines);
+
+	// subroutines, from all the call stacks they appear in
+	count = 0;
+	for (uint32_t node = 1; node < nodes; node++)
+		spots[count++] = (spot_t){ profile->tree[node].cycles, profile->tree[node].instructions, profile->tree[node].address };
+	qsort(spots, count, sizeof(spot_t), byAddress);
+	size_t merged = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (merged && spots[merged - 1].address == spots[i].address) {
+			spots[merged - 1].cycles += spots[i].cycles;
+			spots[merged - 1].instructions += spots[i].instructions;
+		} else
+			spots[merged++] = spots[i];
+	}
+	profileSpots(file, "subroutines, without their callees", spots, merged, total, lines);
+
+	free(spots);
+	return fclose(file) == 0;
+}
+
+int puce6502ProfileStacks(puce6502_t *cpu, const char *filename) {
+	puce6502_profile_t *profile = cpu->profile;
+	if (!profile)
+		return 0;
+	FILE *file = fopen(filename, "w");
+	if (!file)
+		return 0;
+
+	uint32_t nodes = profile->nodes ? profile->nodes : 1;
+	uint32_t path[PUCE6502_PROFILE_DEPTH + 1];
+	char name[16];
+	for (uint32_t node = 0; node < nodes; node++) {
+		if (!profile->tree[node].cycles)
+			continue;
+		int depth = 0;
+		for (uint32_t up = node; up; up = profile->tree[up].parent)
+			path[depth++] = profile->tree[up].address;
+		fputs(CPU_ID == 0x6502 ? "6502" : "65C02", file);  // the root
+		while (depth--) {
+			profileName(name, path[depth]);
+			fprintf(file, ";%s", name);
+		}
+		fprintf(file, " %llu\n", (unsigned long long)profile->tree[node].cycles);
+	}
+	return fclose(file) == 0;
+}
+
+#else
+
+int puce6502ProfileReport(puce6502_t *cpu, const char *filename, int lines) {
+	return 0;  // built without PUCE6502_PROFILE
+}
+
+int puce6502ProfileStacks(puce6502_t *cpu, const char *filename) {
+	return 0;
+}
+
+#endif
+
+#ifdef PUCE6502_STATS
+
+int puce6502StatsSave(puce6502_t *cpu, const char *filename) {
+	static const char *modes[] = { "IMP", "ACC", "IMM", "ZPG", "ZPX", "ZPY", "REL", "IZP",
+		"IZX", "IZY", "ABS", "ABX", "ABY", "IND", "IAX", "ZPR" };
+	puce6502_stats_t *stats = cpu->stats;
+	if (!stats)
+		return 0;
+	FILE *file = fopen(filename, "w");
+	if (!file)
+		return 0;
+
+	fprintf(file, "opcode,mnemonic,mode,runs,cycles,crossed,taken,not taken\n");
+	for (int op = 0; op < 256; op++) {
+		if (!stats->runs[op])
+			continue;
+		fprintf(file, "$%02X,%s,%s,%llu,%llu,%llu", op, mn[op] ? mn[op] : "UND", modes[am[op]],
+			(unsigned long long)stats->runs[op], (unsigned long long)stats->cycles[op], (unsigned long long)stats->crossed[op]);
+		if (am[op] == REL || am[op] == ZPR)
+			fprintf(file, ",%llu,%llu\n", (unsigned long long)stats->taken[op], (unsigned long long)(stats->runs[op] - stats->taken[op]));
+		else
+			fprintf(file, ",,\n");  // not a branch
+	}
+	return fclose(file) == 0;
+}
+
+#else
+
+int puce6502StatsSave(puce6502_t *cpu, const char *filename) {
+	return 0;  // built without PUCE6502_STATS
+}
+
+#endif
+
+void printRegs(puce6502_t *cpu) {
   printf("A=%02X  X=%02X  Y=%02X  S=%02X  *S=%02X  %c%c%c%c%c%c%c%c", \
 	A, X, Y, SP, readMem(0x100 + SP), \
-	P.S?'N':'-', P.V?'V':'-', P.U?'U':'.', P.B?'B':'-', \
-	P.D?'D':'-', P.I?'I':'-', P.Z?'Z':'-', P.C?'C':'-');
+	FLAG_N?'N':'-', P.V?'V':'-', P.U?'U':'.', P.B?'B':'-', \
+	P.D?'D':'-', P.I?'I':'-', FLAG_Z?'Z':'-', P.C?'C':'-');
 }
 
-void setPC(uint16_t address) {
+void setPC(puce6502_t *cpu, uint16_t address) {
 	PC = address;
 }
 
-uint16_t getPC(){
+uint16_t getPC(puce6502_t *cpu) {
 	return PC;
 }
 
-uint16_t getSP(){
+uint16_t getSP(puce6502_t *cpu) {
 	return SP;
 }
 
-uint8_t getA(){
+uint8_t getA(puce6502_t *cpu) {
 	return A;
 }
 
-uint8_t getX(){
+uint8_t getX(puce6502_t *cpu) {
 	return X;
 }
 
-uint8_t getY(){
+uint8_t getY(puce6502_t *cpu) {
 	return Y;
 }
 
+uint8_t getP(puce6502_t *cpu) {
+	return GET_P();
+}
+
+void setP(puce6502_t *cpu, uint8_t value) {
+	SET_P(value);
+}
+
 
 #if _FUNCTIONNAL_TESTS
 
 		// 6502 functonnal tests
 		// using Klaus Dormann's functonnal tests published at :
 		// https://github.com/Klaus2m5/6502_65C02_functional_tests
+		// puce6502check.c runs them on the block cache and the native code
+		// too, in lockstep with puce6502Step(), and puce6502bench.c times them
+		// along with other workloads
 
 		int main(int argc, char* argv[]){
 
@@ -1980,7 +1225,11 @@ uint8_t getY(){
 		  }
 		  fclose(f);
 
-			puce6502RST();  // reset the CPU
+			puce6502_t test = { 0 };
+			puce6502_t *cpu = &test;
+
+			puce6502Init();
+			puce6502RST(cpu);  // reset the CPU
 			PC = 0x400;  // set Program Counter to start of code
 
 			unsigned long long int oldticks = 0;
@@ -1989,8 +1238,9 @@ uint8_t getY(){
 			// while(1) {
 			// 	dasm(newPC);
 			// 	printf("  ");
-			// 	newPC = puce6502Exec(1);
-			// 	printRegs();
+			// 	puce6502Exec(cpu, 1);
+			// 	newPC = PC;
+			// 	printRegs(cpu);
 			// 	printf("   Cycles: %llu   Total: %llu\n", ticks - oldticks, ticks);
 			// 	oldticks = ticks;
 			//
@@ -2009,7 +1259,7 @@ uint8_t getY(){
 			// }
 
 		  // Benchmark : replace the above while loop by this one
-			  while(puce6502Exec(100) != 0x3469);
+			  while(puce6502Exec(cpu, 100), PC != 0x3469);
 			  printf("%llu\n", ticks);
 		  // and use the time utility to avaluate the speed the emulated 65C02
 
@@ -32,26 +32,203 @@
 #ifndef _PUCE6502_H
 #define _PUCE6502_H
 
+#include <stdint.h>
+
 //typedef unsigned char uint8_t;
 //typedef unsigned short uint16_t;
 //typedef enum { false, true } bool;
 
-extern unsigned long long int ticks;
+typedef struct puce6502 puce6502_t;
+
+// predecoded basic blocks, only used by cores built with PUCE6502_CACHE
+#define PUCE6502_BLOCKS     1024  // direct mapped on the low bits of the start address, power of 2 and >= 256
+#define PUCE6502_BLOCK_SIZE 16    // instructions per block at most
+
+typedef struct {
+	uint16_t pc;  // address of the opcode
+	uint8_t bytes[3];  // opcode and operands
+} puce6502_insn_t;
+
+typedef struct {
+	uint8_t count;  // instructions in the block, 0 when invalid
+	uint8_t hits;  // PUCE6502_JIT : runs before translating it
+	void (*native)(puce6502_t *cpu);  // PUCE6502_JIT : its host code, NULL if none
+	puce6502_insn_t insn[PUCE6502_BLOCK_SIZE];
+} puce6502_block_t;
+
+typedef struct {
+	puce6502_block_t blocks[PUCE6502_BLOCKS];
+	uint8_t code[65536];  // non zero for the bytes a cached instruction was decoded from
+	uint8_t used[256];  // non zero for the pages holding cached blocks
+	uint8_t io[256];  // set by the user : pages never to cache, reading them has side effects
+} puce6502_cache_t;
+
+// last instructions run, only recorded by cores built with PUCE6502_TRACE
+#ifndef PUCE6502_TRACE_SIZE
+#define PUCE6502_TRACE_SIZE (1 << 21)  // records kept, power of 2 : 32 MB
+#endif
+
+typedef struct {
+	uint32_t cycle;  // low bits of ticks when the instruction started
+	uint16_t pc;  // address of the opcode
+	uint8_t bytes[3];  // opcode and operands
+	uint8_t a, x, y, sp, p;  // registers before it ran
+} puce6502_record_t;
+
+typedef struct {
+	uint64_t count;  // records taken so far, the last PUCE6502_TRACE_SIZE are kept
+	int trigger;  // set by the user : PC firing the trigger, -1 for none
+	uint32_t after;  // set by the user : records still taken once it fired
+	uint64_t stopAt;  // count the trace stops at once the trigger fired, 0 to arm it again
+	uint8_t stopped;  // set when the trace stops, cleared by the user to go on
+	puce6502_record_t records[PUCE6502_TRACE_SIZE];
+} puce6502_trace_t;
+
+// what puce6502TraceSave() writes before the records, oldest first
+#define PUCE6502_TRACE_MAGIC "puce6502"
+
+typedef struct {
+	char magic[8];
+	uint32_t cpu;  // 0x6502 or 0x65C02
+	uint32_t records;
+} puce6502_trace_header_t;
+
+// where the cycles go, only counted by cores built with PUCE6502_PROFILE
+#define PUCE6502_PROFILE_BANKS 8  // memory banks told apart at the same address
+#define PUCE6502_PROFILE_NODES 65536  // distinct call stacks
+#define PUCE6502_PROFILE_DEPTH 256  // nested subroutines followed
+
+typedef struct {
+	uint32_t address;  // entry point of the subroutine, bank << 16 | address
+	uint32_t parent, child, sibling;  // in tree[], 0 for none : the root is tree[0]
+	uint64_t instructions, cycles;  // run in the subroutine itself, not in its callees
+} puce6502_node_t;
+
+typedef struct {
+	uint8_t bank[256];  // set by the user : memory bank mapped on each page
+	uint64_t instructions[PUCE6502_PROFILE_BANKS][65536];  // by bank and address
+	uint64_t cycles[PUCE6502_PROFILE_BANKS][65536];
+
+	// call tree, built from JSR and the RTS, RTI or stack pointer moves ending them
+	uint32_t node;  // the current call stack
+	uint32_t nodes;  // used in tree[]
+	uint32_t depth;
+	struct {
+		uint32_t node;  // to return to
+		uint8_t sp;  // before the JSR
+	} frames[PUCE6502_PROFILE_DEPTH];
+	puce6502_node_t tree[PUCE6502_PROFILE_NODES];
+} puce6502_profile_t;
+
+// what runs, only counted by cores built with PUCE6502_STATS
+typedef struct {
+	uint64_t runs[256];  // of each opcode
+	uint64_t cycles[256];
+	uint64_t crossed[256];  // runs paying the page crossing cycle, of an indexed mode or a branch
+	uint64_t taken[256];  // branches taken, runs - taken were not
+} puce6502_stats_t;
+
+// loops waiting for a key, only watched by cores built with PUCE6502_IDLE
+#define PUCE6502_IDLE_SIZE       32  // bytes of a loop, at most
+#define PUCE6502_IDLE_ITERATIONS 8  // alike runs before it is waiting
+
+typedef struct {
+	uint32_t polls;  // set by the user : reads that found nothing to do, KBD with no key
+	uint32_t events;  // set by the user : any other I/O access
+	uint32_t writes;
+	uint16_t loop;  // first address of the loop watched
+	uint16_t iterations;  // its runs in a row polling, without events
+	uint16_t quiet;  // the last of them without writes, the registers as they were
+	uint64_t registers;  // A, X, Y, SP and P at the last run
+	uint8_t idle;  // set when a loop waits for a key, cleared by the user
+} puce6502_idle_t;
+
+// routines the user runs itself, only checked by cores built with PUCE6502_TRAPS
+#define PUCE6502_TRAPS_SIZE 8  // trapped addresses, at most
+
+typedef struct {
+	uint16_t address;  // first instruction of the routine
+	unsigned int (*run)(puce6502_t *cpu, unsigned long long int left);  // does all the routine does, its RTS included : returns its cycles, 0 to run it instead
+} puce6502_trap_t;
+
+typedef struct {
+	int count;  // set by the user, as the rest
+	puce6502_trap_t trap[PUCE6502_TRAPS_SIZE];
+	uint8_t mapped[256];  // non zero for the pages where these routines are, while they are mapped
+	uint8_t skip;  // their cycles are not counted, for runs that are not paced
+} puce6502_traps_t;
+
+// one emulated CPU : every entry point below takes a pointer to it, so that
+// several independent machines can run side by side in the same process, once
+// puce6502Init() built the tables they share
+struct puce6502 {
+	uint16_t PC;  //  Program Counter
+	uint8_t A, X, Y, SP;  // Accumulator, X and y indexes and Stack Pointer
+	union {
+		uint8_t byte;
+		struct {
+			uint8_t C : 1;  // Carry
+			uint8_t Z : 1;  // Zero
+			uint8_t I : 1;  // Interupt-disable
+			uint8_t D : 1;  // Decimal
+			uint8_t B : 1;  // Break
+			uint8_t U : 1;  // Undefined
+			uint8_t V : 1;  // Overflow
+			uint8_t S : 1;  // Sign
+		};
+	} P;  // Processor Status, but for Z and S which are kept in nz
+	uint16_t nz;  // last result : Z is set when its low byte is 0, S when bit 7 or 8 is
+	int state;  // 65c02 only, running, waiting (WAI) or stopped (STP)
+
+	unsigned long long int ticks;  // accumulated number of clock cycles, PUCE6502_CYCLE_EXACT : the current one during bus accesses
+
+	// user provided functions (unused when the core is built with PUCE6502_MEMMAP)
+	uint8_t (*readMem)(puce6502_t *cpu, uint16_t address);
+	void (*writeMem)(puce6502_t *cpu, uint16_t address, uint8_t value);
+	void *machine;  // free for the user, the core never touches it
+	puce6502_cache_t *cache;  // set by the user to enable the block cache, NULL otherwise
+	puce6502_trace_t *trace;  // set by the user to record the instructions, NULL otherwise
+	puce6502_profile_t *profile;  // set by the user to count cycles per address, NULL otherwise
+	puce6502_idle_t *idle;  // set by the user to skip the loops waiting for a key, NULL otherwise
+	puce6502_stats_t *stats;  // set by the user to count the opcodes run, NULL otherwise
+	puce6502_traps_t *traps;  // set by the user to run some routines itself, NULL otherwise
+	uint8_t **readPages;  // PUCE6502_JIT : set by the user, where each page is read from, NULL for I/O
+	uint8_t **writePages;  // and written to
+	void *jit;  // PUCE6502_JIT : host code, managed by the core
+};
+
+void puce6502Init(void);  // builds the decimal mode tables : once, before any CPU runs or another thread starts
+unsigned long long int puce6502Exec(puce6502_t *cpu, unsigned long long int cycleCount);  // returns executed cycles
+void puce6502RST(puce6502_t *cpu);
+void puce6502IRQ(puce6502_t *cpu);
+void puce6502NMI(puce6502_t *cpu);
+
+unsigned int puce6502Step(puce6502_t *cpu);
+
+// drops the cached blocks decoded from these addresses, to be called when the
+// memory seen there changes other than by a CPU write (bank switching, loading)
+void puce6502CacheInvalidate(puce6502_t *cpu, uint16_t first, uint16_t last);
+
+// writes the trace to a file for puce6502trace to disassemble, 0 on error
+int puce6502TraceSave(puce6502_t *cpu, const char *filename);
 
-uint16_t puce6502Exec(unsigned long long int cycleCount);
-void puce6502RST();
-void puce6502IRQ();
-void puce6502NMI();
+// the addresses and subroutines taking the most cycles, lines of each, 0 on error
+int puce6502ProfileReport(puce6502_t *cpu, const char *filename, int lines);
+// the cycles of each call stack, in the collapsed format of flame graph tools
+int puce6502ProfileStacks(puce6502_t *cpu, const char *filename);
 
-unsigned int puce6502Step();
+// the counts of every opcode as CSV, 0 on error
+int puce6502StatsSave(puce6502_t *cpu, const char *filename);
 
-// void printRegs();
-void dasm(uint16_t address, char *buffer);
-void setPC(uint16_t address);
-uint16_t getPC();
-uint16_t getSP();
-uint8_t getA();
-uint8_t getX();
-uint8_t getY();
+// void printRegs(puce6502_t *cpu);
+void dasm(puce6502_t *cpu, uint16_t address, char *buffer);
+void setPC(puce6502_t *cpu, uint16_t address);
+uint16_t getPC(puce6502_t *cpu);
+uint16_t getSP(puce6502_t *cpu);
+uint8_t getA(puce6502_t *cpu);
+uint8_t getX(puce6502_t *cpu);
+uint8_t getY(puce6502_t *cpu);
+uint8_t getP(puce6502_t *cpu);  // the Processor Status with its N and Z flags
+void setP(puce6502_t *cpu, uint8_t value);
 
 #endif
@@ -0,0 +1,216 @@
+/*
+  Puce6502 - CPU throughput benchmark
+
+  Times the core alone on flat RAM, through the readMem() and writeMem()
+  callbacks of the context and without anything of the machines. Each
+  workload is first stepped once with puce6502Step() to count its
+  instructions and cycles up to the JMP * ending it, then run that many
+  cycles by puce6502Exec() as many times as needed to last a while.
+
+    mix     loads, stores, indexing, shifts, branches and a subroutine
+    bcd     decimal mode additions and subtractions
+    copy    4 KB copies through (zp),Y
+    klaus   Klaus Dormann's 6502_functional_test.bin, when found in the
+            current directory, as for the _FUNCTIONNAL_TESTS harness of
+            puce6502.c
+
+  built once per core, 'make bench' builds and runs both :
+    cc -O3 puce6502bench.c puce6502.c -o puce6502bench
+    cc -O3 -DPUCE6502_BENCH_CPU='"65C02"' puce6502bench.c puce65c02.c -o puce65c02bench
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "puce6502.h"
+
+#ifndef PUCE6502_BENCH_CPU
+#define PUCE6502_BENCH_CPU "6502"  // the core linked with, for the report
+#endif
+
+#define BENCH_ORIGIN 0x1000  // where the workloads below are loaded and start
+
+static const uint8_t mix[] = {
+	0xA9, 0x00,          // 1000         LDA #$00       256 times
+	0x85, 0xF0,          // 1002         STA $F0
+	0xA0, 0x00,          // 1004  outer  LDY #$00
+	0x98,                // 1006  inner  TYA
+	0xAA,                // 1007         TAX
+	0x49, 0x5A,          // 1008         EOR #$5A
+	0x9D, 0x00, 0x04,    // 100A         STA $0400,X
+	0xBD, 0x00, 0x04,    // 100D         LDA $0400,X
+	0x0A,                // 1010         ASL A
+	0x6A,                // 1011         ROR A
+	0x20, 0x28, 0x10,    // 1012         JSR sub
+	0xC9, 0x80,          // 1015         CMP #$80
+	0x90, 0x02,          // 1017         BCC low
+	0xE6, 0xF1,          // 1019         INC $F1
+	0x99, 0x00, 0x30,    // 101B  low    STA $3000,Y
+	0x88,                // 101E         DEY
+	0xD0, 0xE5,          // 101F         BNE inner
+	0xC6, 0xF0,          // 1021         DEC $F0
+	0xD0, 0xDF,          // 1023         BNE outer
+	0x4C, 0x25, 0x10,    // 1025  end    JMP end
+	0x48,                // 1028  sub    PHA
+	0x29, 0x0F,          // 1029         AND #$0F
+	0x09, 0x30,          // 102B         ORA #$30
+	0x85, 0xF2,          // 102D         STA $F2
+	0x68,                // 102F         PLA
+	0x24, 0xF2,          // 1030         BIT $F2
+	0x60,                // 1032         RTS
+
+};
+
+static const uint8_t bcd[] = {
+	0xF8,                // 1000         SED
+	0xA9, 0x00,          // 1001         LDA #$00       256 times
+	0x85, 0xF0,          // 1003         STA $F0
+	0xA0, 0x00,          // 1005  outer  LDY #$00
+	0x18,                // 1007  loop   CLC            6 digits counter at $20
+	0xA5, 0x20,          // 1008         LDA $20
+	0x69, 0x01,          // 100A         ADC #$01
+	0x85, 0x20,          // 100C         STA $20
+	0xA5, 0x21,          // 100E         LDA $21
+	0x69, 0x00,          // 1010         ADC #$00
+	0x85, 0x21,          // 1012         STA $21
+	0xA5, 0x22,          // 1014         LDA $22
+	0x69, 0x00,          // 1016         ADC #$00
+	0x85, 0x22,          // 1018         STA $22
+	0x38,                // 101A         SEC            minus the counter at $30
+	0xA5, 0x30,          // 101B         LDA $30
+	0xE5, 0x20,          // 101D         SBC $20
+	0x85, 0x30,          // 101F         STA $30
+	0xA5, 0x31,          // 1021         LDA $31
+	0xE5, 0x21,          // 1023         SBC $21
+	0x85, 0x31,          // 1025         STA $31
+	0xA5, 0x32,          // 1027         LDA $32
+	0xE5, 0x22,          // 1029         SBC $22
+	0x85, 0x32,          // 102B         STA $32
+	0x88,                // 102D         DEY
+	0xD0, 0xD7,          // 102E         BNE loop
+	0xC6, 0xF0,          // 1030         DEC $F0
+	0xD0, 0xD1,          // 1032         BNE outer
+	0xD8,                // 1034         CLD
+	0x4C, 0x35, 0x10,    // 1035  end    JMP end
+
+};
+
+static const uint8_t copy[] = {
+	0xA9, 0x00,          // 1000         LDA #$00       256 times
+	0x85, 0xF0,          // 1002         STA $F0
+	0xA9, 0x00,          // 1004  outer  LDA #$00
+	0x85, 0xF2,          // 1006         STA $F2        from $4000
+	0x85, 0xF4,          // 1008         STA $F4        to $8000
+	0xA9, 0x40,          // 100A         LDA #$40
+	0x85, 0xF3,          // 100C         STA $F3
+	0xA9, 0x80,          // 100E         LDA #$80
+	0x85, 0xF5,          // 1010         STA $F5
+	0xA2, 0x10,          // 1012         LDX #$10       4 KB
+	0xA0, 0x00,          // 1014  page   LDY #$00
+	0xB1, 0xF2,          // 1016  byte   LDA ($F2),Y
+	0x91, 0xF4,          // 1018         STA ($F4),Y
+	0xC8,                // 101A         INY
+	0xD0, 0xF9,          // 101B         BNE byte
+	0xE6, 0xF3,          // 101D         INC $F3
+	0xE6, 0xF5,          // 101F         INC $F5
+	0xCA,                // 1021         DEX
+	0xD0, 0xF0,          // 1022         BNE page
+	0xC6, 0xF0,          // 1024         DEC $F0
+	0xD0, 0xDC,          // 1026         BNE outer
+	0x4C, 0x28, 0x10,    // 1028  end    JMP end
+
+};
+
+typedef struct {
+	const char *name;
+	const uint8_t *code;  // NULL for the functional test, read from its file
+	size_t size;
+	uint16_t end;  // the JMP * it ends on
+	int runs;
+} workload_t;
+
+static const workload_t workloads[] = {
+	{ "mix",   mix,  sizeof(mix),  0x1025, 64 },
+	{ "bcd",   bcd,  sizeof(bcd),  0x1035, 64 },
+	{ "copy",  copy, sizeof(copy), 0x1028, 16 },
+	{ "klaus", NULL, 0,            0x3469, 2 },
+};
+
+static uint8_t RAM[65536];
+
+static uint8_t readRAM(puce6502_t *cpu, uint16_t address) { return RAM[address]; }
+static void writeRAM(puce6502_t *cpu, uint16_t address, uint8_t value) { RAM[address] = value; }
+
+
+// loads the workload and resets the CPU on it, 0 when it can't be found
+static int load(puce6502_t *cpu, const workload_t *workload) {
+	memset(RAM, 0, sizeof(RAM));
+	memset(cpu, 0, sizeof(*cpu));
+	cpu->readMem = readRAM;
+	cpu->writeMem = writeRAM;
+	puce6502RST(cpu);
+
+	if (workload->code) {
+		memcpy(RAM + BENCH_ORIGIN, workload->code, workload->size);
+		setPC(cpu, BENCH_ORIGIN);
+	} else {
+		FILE *file = fopen("6502_functional_test.bin", "rb");
+		if (!file)
+			return 0;
+		size_t size = fread(RAM, 1, sizeof(RAM), file);
+		fclose(file);
+		if (size != sizeof(RAM))
+			return 0;
+		setPC(cpu, 0x400);
+	}
+	return 1;
+}
+
+int main(void) {
+	printf("puce6502 bench, %s core\n\n", PUCE6502_BENCH_CPU);
+	printf("%-8s %5s %14s %14s %8s %8s %8s %8s\n", "workload", "runs", "instructions", "cycles", "seconds", "Minsn/s", "MHz", "ns/insn");
+
+	puce6502Init();
+	puce6502_t cpu;
+	int result = 0;
+	for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+		const workload_t *workload = &workloads[w];
+		if (!load(&cpu, workload)) {
+			printf("%-8s skipped, 6502_functional_test.bin not found\n", workload->name);
+			continue;
+		}
+
+		// counts what a run does, the cycles from there on
+		unsigned long long int instructions = 0, start = cpu.ticks;
+		uint16_t pc;
+		do {
+			pc = getPC(&cpu);
+			cpu.ticks += puce6502Step(&cpu);
+			instructions++;
+		} while (getPC(&cpu) != workload->end && getPC(&cpu) != pc);
+		if (getPC(&cpu) != workload->end) {
+			printf("%-8s failed, loop at $%04X\n", workload->name, pc);
+			result = 1;
+			continue;
+		}
+		unsigned long long int cycles = cpu.ticks - start;
+
+		clock_t begin = clock();
+		for (int run = 0; run < workload->runs; run++) {
+			load(&cpu, workload);
+			puce6502Exec(&cpu, cycles);
+			if (getPC(&cpu) != workload->end) {
+				printf("%-8s run %d ended at $%04X\n", workload->name, run, getPC(&cpu));
+				result = 1;
+			}
+		}
+		double seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+		instructions *= workload->runs;
+		cycles *= workload->runs;
+		printf("%-8s %5d %14llu %14llu %8.3f %8.1f %8.1f %8.2f\n", workload->name, workload->runs, instructions, cycles,
+			seconds, instructions / seconds / 1e6, cycles / seconds / 1e6, seconds * 1e9 / instructions);
+	}
+	return result;
+}
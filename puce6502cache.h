@@ -0,0 +1,138 @@
+/*
+  Puce6502 - predecoded basic blocks cache
+
+  Included by puce6502.c after its memory and register macros, the core
+  derives insnLength[] from the opcode table when PUCE6502_CACHE is set.
+
+  A block is a straight run of instructions starting at a given PC, each one
+  stored with its operand bytes : running it fetches nothing from memory but
+  the operands' targets. A block ends on any instruction that may not fall
+  through (insnLength[] is 0 for them), after PUCE6502_BLOCK_SIZE instructions
+  or before an instruction that would read the next page.
+
+  Blocks are never built from the pages the user marked in cache->io. A CPU
+  write to a byte a block was decoded from drops all the blocks of its page,
+  the user calls puce6502CacheInvalidate() when the memory mapped at some
+  addresses changes by other means (bank switching, loading a file in RAM).
+  ROM blocks thus stay cached as long as the ROM remains mapped.
+
+  Cores built with PUCE6502_JIT also translate hot blocks to host code, see
+  puce6502jit.h.
+*/
+
+#ifndef _PUCE6502CACHE_H
+#define _PUCE6502CACHE_H
+
+void puce6502CacheInvalidate(puce6502_t *cpu, uint16_t first, uint16_t last) {
+	puce6502_cache_t *cache = cpu->cache;
+	if (!cache)
+		return;
+
+	for (int page = first >> 8; page <= last >> 8; page++) {
+		if (!cache->used[page])
+			continue;
+		// the blocks of a page all sit in the same 256 consecutive slots
+		puce6502_block_t *block = cache->blocks + ((page << 8) & (PUCE6502_BLOCKS - 1));
+		for (int slot = 0; slot < 256; slot++, block++)
+			if (block->count && block->insn[0].pc >> 8 == page)
+				block->count = 0;
+		memset(cache->code + (page << 8), 0, 256);
+		cache->used[page] = 0;
+	}
+}
+
+
+#ifdef PUCE6502_CACHE
+
+// the block starting at PC, decoded if needed, or NULL when PC can't be cached
+static puce6502_block_t *cacheBlock(puce6502_t *cpu) {
+	puce6502_cache_t *cache = cpu->cache;
+	if (!cache || cache->io[PC >> 8])
+		return NULL;
+
+	puce6502_block_t *block = &cache->blocks[PC & (PUCE6502_BLOCKS - 1)];
+	if (!block->count || block->insn[0].pc != PC) {
+		uint16_t pc = PC;
+		uint8_t length;
+		int count = 0;
+		do {
+			if ((pc & 0xFF) > 0xFD)  // operands would come from the next page
+				break;
+			puce6502_insn_t *insn = &block->insn[count++];
+			insn->pc = pc;
+			for (int i = 0; i < 3; i++) {
+				insn->bytes[i] = readMem(pc + i);
+				cache->code[pc + i] = 1;
+			}
+			length = insnLength[insn->bytes[0]];
+			pc += length;
+		} while (length && count < PUCE6502_BLOCK_SIZE);
+
+		block->count = count;
+		block->hits = 0;
+		block->native = NULL;
+		if (!count)
+			return NULL;
+		cache->used[PC >> 8] = 1;
+	}
+	return block;
+}
+
+// returns the predecoded instructions starting at PC, or NULL when PC can't be
+// cached. With PUCE6502_JIT, hot blocks first run natively as long as the
+// budget (ticks up to limit) has room for a whole one.
+static const puce6502_insn_t *cacheLookup(puce6502_t *cpu, const puce6502_block_t **current, unsigned long long int limit) {
+	puce6502_block_t *block = cacheBlock(cpu);
+
+#ifdef PUCE6502_JIT
+	while (block && limit - ticks > JIT_CYCLES && !TRAPPED(PC)) {  // the interpreter runs the traps
+		if (!block->native) {
+			if (block->hits == PUCE6502_JIT_HOT || ++block->hits < PUCE6502_JIT_HOT)
+				break;
+			jitCompile(cpu, block);  // tried once, hits stays at PUCE6502_JIT_HOT
+			if (!block->native)
+				break;
+		}
+		unsigned long long int before = ticks;
+		block->native(cpu);
+		if (ticks == before)  // left on its first instruction
+			break;
+		SPIN_WRITE();  // the ones it made are not seen
+		block = cacheBlock(cpu);
+	}
+#endif
+
+	if (!block)
+		return NULL;
+	*current = block;
+	return block->insn;
+}
+
+// CPU writes drop the blocks decoded from the written byte's page
+static inline void cacheWrite(puce6502_t *cpu, uint16_t address, uint8_t value) {
+	if (cpu->cache && cpu->cache->code[address])
+		puce6502CacheInvalidate(cpu, address, address);
+	writeMem(address, value);
+}
+
+#undef writeMem
+#define writeMem(address, value) cacheWrite(cpu, address, value)
+
+// next opcode : from the current block while it runs straight, else from the
+// block at PC, else from memory
+#define FETCH_OPCODE() ( \
+	insn = (insn && ++insn < block->insn + block->count && insn->pc == PC) ? insn : cacheLookup(cpu, &block, cycleCount), \
+	PC++, \
+	insn ? insn->bytes[0] : readMem(PC - 1))
+
+// operand bytes of the current instruction
+#define FETCH(address) (insn ? insn->bytes[(uint16_t)((address) - insn->pc)] : readMem(address))
+
+#else
+
+#define FETCH_OPCODE() readMem(PC++)
+#define FETCH(address) readMem(address)
+
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+/*
+  Puce6502 - lockstep checker of the fast cores
+
+  Runs a program on two CPUs in their own copy of memory : the reference one
+  only ever goes through puce6502Step(), the other through puce6502Exec() with
+  the block cache given, and the native code too when the core is built with
+  PUCE6502_JIT. After each run of the latter, the reference steps until it
+  reached the same ticks value and both are compared : registers, cycles and
+  the writes made on the way. The first difference stops the check with both
+  states and the instructions the reference ran since the last match.
+
+  Native blocks write straight to the page tables, bypassing writeMem() : with
+  PUCE6502_JIT the bytes written by either CPU are compared instead of the two
+  write logs, and the whole memory at the end.
+
+  usage : puce6502check [image.bin [start success [cycles]]]
+  image.bin is loaded at $0000, up to 64 KB. The program starts at start and
+  passes when PC reaches success, both in hex, the default being Klaus
+  Dormann's 6502_functional_test.bin (start 400, success 3469), as for the
+  _FUNCTIONNAL_TESTS harness of puce6502.c. Any other loop on itself is a
+  failed test, the two CPUs agreeing. cycles is the budget of each run of the
+  fast CPU, PUCE6502_CHECK_BUDGET by default : the native code only runs
+  blocks that fit whole in it, 1 narrows a difference down to its instruction.
+
+  built with the cores it checks :
+    cc -O2 -DPUCE6502_CACHE puce6502check.c puce6502.c -o puce6502check
+  add -DPUCE6502_JIT for the native code, use puce65c02.c for the 65C02. The
+  Makefile builds the first two, as puce6502check and puce6502checkjit.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puce6502.h"
+
+#define PUCE6502_CHECK_BUDGET 256  // cycles, more than the native code of a whole block
+#define CHECK_BUDGET_MAX      4096
+#define CHECK_LOG             (CHECK_BUDGET_MAX + 8)  // writes and instructions of one run, at most
+
+typedef struct {
+	puce6502_t cpu;
+	uint8_t ram[65536];
+	uint8_t *pages[256];  // PUCE6502_JIT : the same RAM, by page
+	uint16_t address[CHECK_LOG];  // writes since the last comparison
+	uint8_t value[CHECK_LOG];
+	int writes;
+} machine_t;
+
+static machine_t reference, fast;
+#ifdef PUCE6502_CACHE
+static puce6502_cache_t cache;
+#endif
+
+static uint8_t readRAM(puce6502_t *cpu, uint16_t address) {
+	return ((machine_t *)cpu->machine)->ram[address];
+}
+
+static void writeRAM(puce6502_t *cpu, uint16_t address, uint8_t value) {
+	machine_t *machine = cpu->machine;
+	machine->ram[address] = value;
+	if (machine->writes < CHECK_LOG) {
+		machine->address[machine->writes] = address;
+		machine->value[machine->writes] = value;
+	}
+	machine->writes++;
+}
+
+static void machineInit(machine_t *machine, const uint8_t *image, uint16_t start) {
+	memcpy(machine->ram, image, 65536);
+	for (int page = 0; page < 256; page++)
+		machine->pages[page] = machine->ram + (page << 8);
+	machine->cpu.readMem = readRAM;
+	machine->cpu.writeMem = writeRAM;
+	machine->cpu.machine = machine;
+	puce6502RST(&machine->cpu);
+	machine->cpu.PC = start;
+	machine->writes = 0;
+}
+
+
+// the registers of both CPUs, the ones differing marked
+static int compareRegisters(void) {
+	puce6502_t *r = &reference.cpu, *f = &fast.cpu;
+	const struct { const char *name; unsigned long long int a, b; } regs[] = {
+		{ "PC", r->PC, f->PC }, { "A", r->A, f->A }, { "X", r->X, f->X }, { "Y", r->Y, f->Y },
+		{ "SP", r->SP, f->SP }, { "P", getP(r), getP(f) }, { "state", r->state, f->state },
+		{ "ticks", r->ticks, f->ticks }
+	};
+	int differ = 0;
+	for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+		differ |= regs[i].a != regs[i].b;
+	if (differ) {
+		printf("\n        %20s %20s\n", "reference", "fast");
+		for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+			printf("%-6s  %20llX %20llX%s\n", regs[i].name, regs[i].a, regs[i].b, regs[i].a != regs[i].b ? "  <--" : "");
+	}
+	return differ;
+}
+
+static void printWrites(const char *name, const machine_t *machine) {
+	printf("\n%s wrote %d bytes :", name, machine->writes);
+	for (int i = 0; i < machine->writes && i < CHECK_LOG; i++)
+		printf("%s$%04X=%02X", i % 8 ? " " : "\n  ", machine->address[i], machine->value[i]);
+	printf("\n");
+}
+
+// the writes of the last run, 0 when they match
+static int compareWrites(void) {
+	int differ = 0;
+#ifdef PUCE6502_JIT
+	for (int i = 0; i < reference.writes && i < CHECK_LOG; i++)
+		differ |= fast.ram[reference.address[i]] != reference.ram[reference.address[i]];
+	for (int i = 0; i < fast.writes && i < CHECK_LOG; i++)
+		differ |= fast.ram[fast.address[i]] != reference.ram[fast.address[i]];
+#else
+	differ = reference.writes != fast.writes
+		|| memcmp(reference.address, fast.address, reference.writes * sizeof(uint16_t))
+		|| memcmp(reference.value, fast.value, reference.writes);
+#endif
+	if (differ) {
+		printWrites("reference", &reference);
+		printWrites("fast", &fast);
+	}
+	return differ;
+}
+
+// the first bytes where the memories differ, 0 when they don't
+static int compareMemory(void) {
+	int differ = 0;
+	for (int address = 0; address < 65536; address++)
+		if (reference.ram[address] != fast.ram[address] && differ++ < 16)
+			printf("$%04X  reference %02X  fast %02X\n", address, reference.ram[address], fast.ram[address]);
+	return differ;
+}
+
+
+int main(int argc, char *argv[]) {
+	const char *filename = argc > 1 ? argv[1] : "6502_functional_test.bin";
+	uint16_t start = argc > 3 ? strtol(argv[2], NULL, 16) : 0x400;
+	uint16_t success = argc > 3 ? strtol(argv[3], NULL, 16) : 0x3469;
+	unsigned long long int budget = argc > 4 ? strtoull(argv[4], NULL, 10) : PUCE6502_CHECK_BUDGET;
+	if (budget < 1 || budget > CHECK_BUDGET_MAX) {
+		fprintf(stderr, "cycles : 1 to %d\n", CHECK_BUDGET_MAX);
+		return 2;
+	}
+
+	static uint8_t image[65536];
+	FILE *file = fopen(filename, "rb");
+	if (!file) {
+		perror(filename);
+		return 2;
+	}
+	size_t size = fread(image, 1, sizeof(image), file);
+	fclose(file);
+	printf("%s : %zu bytes, from $%04X to $%04X, %llu cycles per run\n", filename, size, start, success, budget);
+
+	puce6502Init();
+	machineInit(&reference, image, start);
+	machineInit(&fast, image, start);
+#ifdef PUCE6502_CACHE
+	fast.cpu.cache = &cache;
+#endif
+#ifdef PUCE6502_JIT
+	fast.cpu.readPages = fast.pages;
+	fast.cpu.writePages = fast.pages;
+#endif
+
+	static char ran[CHECK_LOG][64];  // the reference's instructions since the last match
+	unsigned long long int instructions = 0, cycles = 0;  // of the reference, up to the end of the test
+	int result = 0;
+
+	for (;;) {
+		reference.writes = fast.writes = 0;
+		puce6502Exec(&fast.cpu, budget);
+
+		int count = 0, ended = 0;
+		while (reference.cpu.ticks < fast.cpu.ticks) {  // the fast CPU may go on past the end, the reference too
+			uint16_t pc = reference.cpu.PC;
+			dasm(&reference.cpu, pc, ran[count++ % CHECK_LOG]);
+			reference.cpu.ticks += puce6502Step(&reference.cpu);
+			if (!ended) {
+				instructions++;
+				if (reference.cpu.PC == success)
+					ended = 1;
+				else if (reference.cpu.PC == pc)
+					ended = 2;
+				if (ended)
+					cycles = reference.cpu.ticks;
+			}
+		}
+
+		if (compareRegisters() | compareWrites()) {
+			printf("\ndiverged after %llu instructions, the reference ran since the last match :\n", instructions);
+			for (int i = count > CHECK_LOG ? count - CHECK_LOG : 0; i < count; i++)
+				printf("  %s\n", ran[i % CHECK_LOG]);
+			return 1;
+		}
+
+		if (ended == 1) {
+			printf("reached $%04X after %llu instructions, %llu cycles\n", success, instructions, cycles);
+			break;
+		}
+		if (ended == 2) {
+			printf("test failed : loop at $%04X after %llu instructions, %llu cycles\n", reference.cpu.PC, instructions, cycles);
+			result = 1;
+			break;
+		}
+	}
+
+	if (compareMemory()) {
+		printf("the memories differ at the end\n");
+		return 1;
+	}
+	printf("both CPUs agree\n");
+	return result;
+}
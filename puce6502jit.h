@@ -0,0 +1,734 @@
+/*
+  Puce6502 - native x86-64 code for hot blocks
+
+  Included by puce6502.c when built with PUCE6502_JIT, which also needs
+  PUCE6502_CACHE. A cached block entered PUCE6502_JIT_HOT times is translated
+  to host code that works straight on the user's page tables (cpu->readPages
+  and cpu->writePages, one pointer per 256 bytes page). The 6502 registers stay
+  in host registers for the whole block, the last result (cpu->nz, giving N
+  and Z) too.
+
+  The host code runs the longest prefix of the block made of the opcodes
+  below. It leaves to the interpreter, with PC on the instruction it could not
+  run and nothing of it done, on a read from a page whose readPages entry is
+  NULL (the I/O pages), on a write to a page whose writePages entry is NULL or
+  to a byte a cached block was decoded from, and on ADC and SBC in decimal
+  mode. The cycles are those of the interpreter, added to ticks on leaving the
+  block.
+
+  A block only runs natively when the budget has room for all of it, so that
+  puce6502Exec() stops where it did and puce6502Step() never runs host code.
+*/
+
+#ifndef _PUCE6502JIT_H
+#define _PUCE6502JIT_H
+
+#if !defined(__x86_64__) && !defined(_M_X64)
+	#error "PUCE6502_JIT needs an x86-64 host"
+#endif
+#ifndef PUCE6502_CACHE
+	#error "PUCE6502_JIT needs PUCE6502_CACHE"
+#endif
+#ifdef PUCE6502_CMOS
+	#error "PUCE6502_JIT only translates NMOS code"
+#endif
+
+#ifndef PUCE6502_JIT_HOT
+#define PUCE6502_JIT_HOT 16  // runs of a block before its translation, 255 at most
+#endif
+
+#define JIT_ARENA     (1 << 20)  // bytes of host code, all dropped when full
+#define JIT_BLOCK_MAX 8192  // host code for one block, at most
+#define JIT_EXITS     128  // side exits of one block, at most
+#define JIT_CYCLES    (PUCE6502_BLOCK_SIZE * 8)  // 6502 cycles of one block, more than
+
+
+typedef struct {
+	uint8_t *code;  // executable memory, NULL if the system refused it
+	size_t used;
+} jitArena_t;
+
+// the opcodes of the table in puce6502ops.h, zero cycles for the undefined ones
+#define JIT_OPCODE(opcode, mnemonic, mode, clocks, cross, cpus) \
+	ON_##cpus([opcode] = { mnemonic, mode, clocks, cross },)
+
+static const struct {
+	uint8_t op, mode;
+	uint8_t cycles;  // as counted by the interpreter
+	uint8_t cross;  // one more cycle when indexing crosses a page
+} jitOpcodes[256] = { PUCE6502_OPCODES(JIT_OPCODE) };
+
+
+// host registers
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+#define J_CPU   RBX  // puce6502_t *
+#define J_READ  RBP  // cpu->readPages
+#define J_WRITE RSI  // cpu->writePages
+#define J_CODE  RDI  // cpu->cache->code
+#define J_A     R8   // 6502 registers, zero extended
+#define J_X     R9
+#define J_Y     R10
+#define J_C     R11  // carry, 0 or 1
+#define J_NZ    R12  // cpu->nz
+#define J_TICKS R13  // page crossing cycles, the others are known when translating
+#define J_TMP   R14
+#define J_CROSS R15  // page crossing cycle of the current instruction
+
+#define J_W64 1  // operand sizes
+#define J_B8  2
+#define J_W16 4
+
+// offset of a 6502 register in *cpu
+#define OFF(field) ((int32_t)((uint8_t *)&(field) - (uint8_t *)cpu))
+
+typedef struct {
+	puce6502_t *cpu;
+	uint8_t *p;  // where the next host instruction goes
+	uint8_t *epilogue;  // every exit of the block ends there
+	uint16_t pc;  // 6502 instruction being translated
+	unsigned cycles;  // of the instructions translated before it
+	bool done;  // PC was set by the last instruction
+	int exits;
+	struct {
+		uint8_t *jump;  // rel32 to patch
+		uint16_t pc;
+		unsigned cycles;
+	} exit[JIT_EXITS];
+} jit_t;
+
+
+static void hostImm8(jit_t *j, uint8_t value) {
+	*j->p++ = value;
+}
+
+static void hostImm32(jit_t *j, uint32_t value) {
+	for (int i = 0; i < 4; i++, value >>= 8)
+		*j->p++ = value & 0xFF;
+}
+
+// prefixes and opcode, two bytes opcodes have 0x0F in their high byte
+static void hostOp(jit_t *j, int size, unsigned code, int reg, int index, int base) {
+	if (size & J_W16)
+		*j->p++ = 0x66;
+	uint8_t rex = 0x40 | (size & J_W64 ? 8 : 0) | (reg & 8) >> 1 | (index & 8) >> 2 | (base & 8) >> 3;
+	if (rex != 0x40 || size & J_B8)  // a bare REX makes sil, dil, spl and bpl byte operands
+		*j->p++ = rex;
+	if (code > 0xFF)
+		*j->p++ = code >> 8;
+	*j->p++ = code & 0xFF;
+}
+
+// op reg, rm (reg is the /digit of single operand opcodes)
+static void hostRR(jit_t *j, int size, unsigned code, int reg, int rm) {
+	hostOp(j, size, code, reg, 0, rm);
+	*j->p++ = 0xC0 | (reg & 7) << 3 | (rm & 7);
+}
+
+// op reg, [base + disp32]
+static void hostRM(jit_t *j, int size, unsigned code, int reg, int base, int32_t disp) {
+	hostOp(j, size, code, reg, 0, base);
+	*j->p++ = 0x80 | (reg & 7) << 3 | (base & 7);
+	if ((base & 7) == RSP)
+		*j->p++ = 0x24;
+	hostImm32(j, disp);
+}
+
+// op reg, [base + index << scale]
+static void hostRX(jit_t *j, int size, unsigned code, int reg, int base, int index, int scale) {
+	hostOp(j, size, code, reg, index, base);
+	if ((base & 7) == RBP) {  // no encoding without a displacement
+		*j->p++ = 0x44 | (reg & 7) << 3;
+		*j->p++ = scale << 6 | (index & 7) << 3 | (base & 7);
+		*j->p++ = 0;
+	} else {
+		*j->p++ = 0x04 | (reg & 7) << 3;
+		*j->p++ = scale << 6 | (index & 7) << 3 | (base & 7);
+	}
+}
+
+static void hostMov(jit_t *j, int dst, int src) {
+	hostRR(j, 0, 0x8B, dst, src);
+}
+
+static void hostMovImm(jit_t *j, int reg, uint32_t value) {
+	if (reg & 8)
+		*j->p++ = 0x41;
+	*j->p++ = 0xB8 | (reg & 7);
+	hostImm32(j, value);
+}
+
+// add (0), or (1), and (4), sub (5), xor (6), cmp (7) with a 32 bits immediate
+static void hostAlu(jit_t *j, int digit, int reg, uint32_t value) {
+	hostRR(j, 0, 0x81, digit, reg);
+	hostImm32(j, value);
+}
+
+// shl (4), shr (5)
+static void hostShift(jit_t *j, int digit, int reg, uint8_t count) {
+	hostRR(j, 0, 0xC1, digit, reg);
+	hostImm8(j, count);
+}
+
+// same on P, with an 8 bits immediate
+static void hostAluP(jit_t *j, int digit, uint8_t value) {
+	puce6502_t *cpu = j->cpu;
+	hostRM(j, 0, 0x80, digit, J_CPU, OFF(P));
+	hostImm8(j, value);
+}
+
+static void hostPush(jit_t *j, int reg) {
+	if (reg & 8)
+		*j->p++ = 0x41;
+	*j->p++ = 0x50 | (reg & 7);
+}
+
+static void hostPop(jit_t *j, int reg) {
+	if (reg & 8)
+		*j->p++ = 0x41;
+	*j->p++ = 0x58 | (reg & 7);
+}
+
+// host condition codes
+#define J_JZ  0x84
+#define J_JNZ 0x85
+
+// conditional jump, returns the rel32 to patch
+static uint8_t *hostJcc(jit_t *j, int cc) {
+	*j->p++ = 0x0F;
+	*j->p++ = cc;
+	j->p += 4;
+	return j->p - 4;
+}
+
+static void hostPatch(uint8_t *jump, const uint8_t *target) {
+	int32_t rel = (int32_t)(target - (jump + 4));
+	for (int i = 0; i < 4; i++, rel >>= 8)
+		jump[i] = rel & 0xFF;
+}
+
+
+// leaves the block, updating PC and ticks
+static void jitLeave(jit_t *j, int pc, unsigned cycles) {
+	puce6502_t *cpu = j->cpu;
+	if (pc >= 0) {  // else already stored
+		hostRM(j, J_W16, 0xC7, 0, J_CPU, OFF(PC));
+		*j->p++ = pc & 0xFF;
+		*j->p++ = pc >> 8;
+	}
+	if (cycles) {
+		hostRR(j, J_W64, 0x81, 0, J_TICKS);
+		hostImm32(j, cycles);
+	}
+	*j->p++ = 0xE9;  // jmp epilogue
+	j->p += 4;
+	hostPatch(j->p - 4, j->epilogue);
+}
+
+// conditional side exit to a given PC
+static void jitJumpTo(jit_t *j, int cc, uint16_t pc, unsigned cycles) {
+	j->exit[j->exits].jump = hostJcc(j, cc);
+	j->exit[j->exits].pc = pc;
+	j->exit[j->exits].cycles = cycles;
+	j->exits++;
+}
+
+// conditional side exit to the interpreter, for the current instruction
+static void jitExitIf(jit_t *j, int cc) {
+	jitJumpTo(j, cc, j->pc, j->cycles);
+}
+
+
+// dst = table[ecx >> 8], leaving the block if NULL
+static void jitPage(jit_t *j, int table, int dst) {
+	hostMov(j, RAX, RCX);
+	hostShift(j, 5, RAX, 8);
+	hostRX(j, J_W64, 0x8B, dst, table, RAX, 3);
+	hostRR(j, J_W64, 0x85, dst, dst);  // test
+	jitExitIf(j, J_JZ);
+}
+
+// eax = byte at ecx
+static void jitRead(jit_t *j) {
+	jitPage(j, J_READ, RDX);
+	hostRR(j, J_B8, 0x0FB6, RAX, RCX);  // movzx eax, cl
+	hostRX(j, 0, 0x0FB6, RAX, RDX, RAX, 0);
+}
+
+// r14 = where to write the byte at ecx, leaving the block if it is cached code
+static void jitWriteCheck(jit_t *j) {
+	jitPage(j, J_WRITE, J_TMP);
+	hostRX(j, 0, 0x80, 7, J_CODE, RCX, 0);  // cmp byte [rdi + rcx], 0
+	hostImm8(j, 0);
+	jitExitIf(j, J_JNZ);
+}
+
+// byte at ecx = reg, after jitWriteCheck()
+static void jitWrite(jit_t *j, int reg) {
+	hostRR(j, J_B8, 0x0FB6, RDX, RCX);  // movzx edx, cl
+	hostRX(j, J_B8, 0x88, reg, J_TMP, RDX, 0);
+}
+
+// ecx = operand address, J_CROSS = page crossing cycle if cross
+static void jitAddress(jit_t *j, int mode, const uint8_t *bytes, bool cross) {
+	uint16_t operand = bytes[1] | bytes[2] << 8;
+	int index = (mode == ABX || mode == ZPX) ? J_X : J_Y;
+
+	switch (mode) {
+		case ZPG:
+			hostMovImm(j, RCX, bytes[1]);
+			break;
+		case ABS:
+			hostMovImm(j, RCX, operand);
+			break;
+		case ZPX:
+		case ZPY:
+			hostRM(j, 0, 0x8D, RCX, index, bytes[1]);  // lea
+			hostRR(j, J_B8, 0x0FB6, RCX, RCX);
+			break;
+		case ABX:
+		case ABY:
+			if (cross) {
+				hostRM(j, 0, 0x8D, J_CROSS, index, bytes[1]);
+				hostShift(j, 5, J_CROSS, 8);
+			}
+			hostRM(j, 0, 0x8D, RCX, index, operand);
+			hostRR(j, 0, 0x0FB7, RCX, RCX);  // movzx ecx, cx
+			break;
+		case IZX:
+		case IZY:
+			hostRM(j, J_W64, 0x8B, RDX, J_READ, 0);  // zero page
+			hostRR(j, J_W64, 0x85, RDX, RDX);
+			jitExitIf(j, J_JZ);
+			if (mode == IZX) {
+				hostRM(j, 0, 0x8D, RAX, J_X, bytes[1]);
+				hostRR(j, J_B8, 0x0FB6, RAX, RAX);
+				hostRX(j, 0, 0x0FB6, RCX, RDX, RAX, 0);
+				hostRR(j, J_B8, 0xFE, 0, RAX);  // inc al
+				hostRX(j, 0, 0x0FB6, RAX, RDX, RAX, 0);
+			} else {
+				hostRM(j, 0, 0x0FB6, RCX, RDX, bytes[1]);
+				hostRM(j, 0, 0x0FB6, RAX, RDX, (uint8_t)(bytes[1] + 1));
+			}
+			hostShift(j, 4, RAX, 8);
+			hostRR(j, 0, 0x0B, RCX, RAX);  // or
+			if (mode == IZY) {
+				if (cross) {
+					hostRR(j, J_B8, 0x0FB6, J_CROSS, RCX);
+					hostRR(j, 0, 0x03, J_CROSS, J_Y);  // add
+					hostShift(j, 5, J_CROSS, 8);
+				}
+				hostRR(j, 0, 0x03, RCX, J_Y);
+				hostRR(j, 0, 0x0FB7, RCX, RCX);
+			}
+			break;
+	}
+}
+
+// eax = operand value
+static void jitOperand(jit_t *j, int mode, const uint8_t *bytes, bool cross) {
+	if (mode == IMM) {
+		hostMovImm(j, RAX, bytes[1]);
+		return;
+	}
+	jitAddress(j, mode, bytes, cross);
+	jitRead(j);
+	if (cross)  // past the last exit of the instruction
+		hostRR(j, J_W64, 0x01, J_CROSS, J_TICKS);  // add r13, r15
+}
+
+static void jitResult(jit_t *j, int reg) {
+	hostMov(j, J_NZ, reg);
+}
+
+// shifts and rotations of eax
+static void jitShift(jit_t *j, int op) {
+	switch (op) {
+		case ASL:
+			hostMov(j, J_C, RAX);
+			hostShift(j, 5, J_C, 7);
+			hostRR(j, J_B8, 0x00, RAX, RAX);  // add al, al
+			break;
+		case LSR:
+			hostMov(j, J_C, RAX);
+			hostAlu(j, 4, J_C, 1);
+			hostShift(j, 5, RAX, 1);
+			break;
+		case ROL:
+			hostRR(j, 0, 0x03, RAX, RAX);
+			hostRR(j, 0, 0x0B, RAX, J_C);
+			hostMov(j, J_C, RAX);
+			hostShift(j, 5, J_C, 8);
+			hostRR(j, J_B8, 0x0FB6, RAX, RAX);
+			break;
+		case ROR:
+			hostMov(j, RDX, J_C);
+			hostShift(j, 4, RDX, 7);
+			hostMov(j, J_C, RAX);
+			hostAlu(j, 4, J_C, 1);
+			hostShift(j, 5, RAX, 1);
+			hostRR(j, 0, 0x0B, RAX, RDX);
+			break;
+	}
+}
+
+// an opcode's page is likely I/O : leave it to the interpreter
+static bool jitIO(puce6502_t *cpu, int mode, uint16_t operand, bool read, bool write) {
+	if (mode != ABS && mode != ABX && mode != ABY)
+		return false;
+	return (read && !cpu->readPages[operand >> 8]) || (write && !cpu->writePages[operand >> 8]);
+}
+
+// translates one instruction, false for the ones left to the interpreter
+static bool jitInstruction(jit_t *j, const puce6502_insn_t *insn) {
+	puce6502_t *cpu = j->cpu;
+	const uint8_t *bytes = insn->bytes;
+	int op = jitOpcodes[bytes[0]].op;
+	int mode = jitOpcodes[bytes[0]].mode;
+	bool cross = jitOpcodes[bytes[0]].cross;
+	uint16_t operand = bytes[1] | bytes[2] << 8;
+	unsigned cycles = j->cycles + jitOpcodes[bytes[0]].cycles;
+	int reg = 0;
+
+	if (!jitOpcodes[bytes[0]].cycles)
+		return false;
+
+	switch (op) {
+		case LDA: case LDX: case LDY:
+			if (jitIO(cpu, mode, operand, true, false))
+				return false;
+			reg = op == LDA ? J_A : op == LDX ? J_X : J_Y;
+			jitOperand(j, mode, bytes, cross);
+			hostMov(j, reg, RAX);
+			jitResult(j, reg);
+			break;
+
+		case STA: case STX: case STY:
+			if (jitIO(cpu, mode, operand, false, true))
+				return false;
+			reg = op == STA ? J_A : op == STX ? J_X : J_Y;
+			jitAddress(j, mode, bytes, false);
+			jitWriteCheck(j);
+			jitWrite(j, reg);
+			break;
+
+		case ORA: case AND: case EOR:
+			if (jitIO(cpu, mode, operand, true, false))
+				return false;
+			jitOperand(j, mode, bytes, cross);
+			hostRR(j, 0, op == ORA ? 0x0B : op == AND ? 0x23 : 0x33, J_A, RAX);
+			jitResult(j, J_A);
+			break;
+
+		case ADC: case SBC:
+			if (jitIO(cpu, mode, operand, true, false))
+				return false;
+			hostRM(j, 0, 0xF6, 0, J_CPU, OFF(P));  // test byte [P], DECIM
+			hostImm8(j, DECIM);
+			jitExitIf(j, J_JNZ);
+			jitOperand(j, mode, bytes, cross);
+			if (op == SBC)
+				hostAlu(j, 6, RAX, 0xFF);
+			hostMov(j, RCX, RAX);  // ecx = M, eax = A + M + C
+			hostRR(j, 0, 0x03, RAX, J_A);
+			hostRR(j, 0, 0x03, RAX, J_C);
+			hostMov(j, RDX, RAX);  // V = (r ^ A) & (r ^ M) & 0x80
+			hostRR(j, 0, 0x33, RDX, J_A);
+			hostMov(j, J_TMP, RAX);
+			hostRR(j, 0, 0x33, J_TMP, RCX);
+			hostRR(j, 0, 0x23, RDX, J_TMP);
+			hostAlu(j, 4, RDX, 0x80);
+			hostShift(j, 5, RDX, 1);
+			hostAluP(j, 4, (uint8_t)~OFLOW);
+			hostRM(j, J_B8, 0x08, RDX, J_CPU, OFF(P));  // or [P], dl
+			hostMov(j, J_C, RAX);
+			hostShift(j, 5, J_C, 8);
+			hostRR(j, J_B8, 0x0FB6, J_A, RAX);
+			jitResult(j, J_A);
+			break;
+
+		case CMP: case CPX: case CPY:
+			if (jitIO(cpu, mode, operand, true, false))
+				return false;
+			reg = op == CMP ? J_A : op == CPX ? J_X : J_Y;
+			jitOperand(j, mode, bytes, cross);
+			hostMov(j, J_NZ, reg);
+			hostRR(j, 0, 0x2B, J_NZ, RAX);  // sub r12d, eax
+			hostRR(j, J_B8, 0x0F93, 0, J_C);  // setae r11b
+			hostRR(j, J_B8, 0x0FB6, J_NZ, J_NZ);
+			break;
+
+		case BIT:
+			if (jitIO(cpu, mode, operand, true, false))
+				return false;
+			jitOperand(j, mode, bytes, cross);
+			hostAluP(j, 4, (uint8_t)~OFLOW);
+			hostMov(j, RDX, RAX);
+			hostAlu(j, 4, RDX, OFLOW);
+			hostRM(j, J_B8, 0x08, RDX, J_CPU, OFF(P));  // or [P], dl
+			hostMov(j, J_NZ, RAX);  // nz = (M & SIGN) << 1 | ((A & M) != 0)
+			hostAlu(j, 4, J_NZ, SIGN);
+			hostShift(j, 4, J_NZ, 1);
+			hostRR(j, 0, 0x85, J_A, RAX);  // test r8d, eax
+			hostRR(j, J_B8, 0x0F95, 0, RDX);  // setnz dl
+			hostRR(j, J_B8, 0x0FB6, RDX, RDX);
+			hostRR(j, 0, 0x0B, J_NZ, RDX);
+			break;
+
+		case INC: case DEC: case ASL: case LSR: case ROL: case ROR:
+			if (mode == ACC) {
+				hostMov(j, RAX, J_A);
+				jitShift(j, op);
+				hostMov(j, J_A, RAX);
+				jitResult(j, J_A);
+				break;
+			}
+			if (jitIO(cpu, mode, operand, true, true))
+				return false;
+			jitAddress(j, mode, bytes, false);
+			jitWriteCheck(j);
+			jitRead(j);
+			if (op == INC || op == DEC)
+				hostRR(j, J_B8, 0xFE, op == DEC, RAX);  // inc al, dec al
+			else
+				jitShift(j, op);
+			jitWrite(j, RAX);
+			jitResult(j, RAX);
+			break;
+
+		case INX: case INY: case DEX: case DEY:
+			reg = (op == INX || op == DEX) ? J_X : J_Y;
+			hostRR(j, J_B8, 0xFE, op == DEX || op == DEY, reg);
+			jitResult(j, reg);
+			break;
+
+		case TAX: case TAY: case TXA: case TYA:
+			reg = op == TAX ? J_X : op == TAY ? J_Y : J_A;
+			hostMov(j, reg, op == TXA ? J_X : op == TYA ? J_Y : J_A);
+			jitResult(j, reg);
+			break;
+
+		case TSX:
+			hostRM(j, 0, 0x0FB6, J_X, J_CPU, OFF(SP));
+			jitResult(j, J_X);
+			break;
+
+		case TXS:
+			hostRM(j, J_B8, 0x88, J_X, J_CPU, OFF(SP));
+			break;
+
+		case CLC:
+			hostRR(j, 0, 0x33, J_C, J_C);  // xor
+			break;
+
+		case SEC:
+			hostMovImm(j, J_C, 1);
+			break;
+
+		case CLV: case CLD: case CLI:
+			hostAluP(j, 4, (uint8_t)~(op == CLV ? OFLOW : op == CLD ? DECIM : INTR));
+			break;
+
+		case SEI:
+			hostAluP(j, 1, INTR);
+			break;
+
+		case NOP:
+			break;
+
+		case PHA:
+			hostRM(j, 0, 0x0FB6, RCX, J_CPU, OFF(SP));
+			hostAlu(j, 1, RCX, 0x100);
+			jitWriteCheck(j);
+			jitWrite(j, J_A);
+			hostRM(j, 0, 0xFE, 1, J_CPU, OFF(SP));  // dec byte [SP]
+			break;
+
+		case PLA:
+			hostRM(j, 0, 0x0FB6, RCX, J_CPU, OFF(SP));
+			hostRR(j, J_B8, 0xFE, 0, RCX);  // inc cl
+			hostAlu(j, 1, RCX, 0x100);
+			jitRead(j);
+			hostRM(j, J_B8, 0x88, RCX, J_CPU, OFF(SP));
+			hostMov(j, J_A, RAX);
+			jitResult(j, J_A);
+			break;
+
+		case JSR:
+			hostRM(j, 0, 0x0FB6, RCX, J_CPU, OFF(SP));
+			hostAlu(j, 1, RCX, 0x100);
+			jitWriteCheck(j);
+			hostMov(j, RDX, RCX);
+			hostRR(j, J_B8, 0xFE, 1, RDX);  // dec dl, still in the stack page
+			hostRX(j, 0, 0x80, 7, J_CODE, RDX, 0);
+			hostImm8(j, 0);
+			jitExitIf(j, J_JNZ);
+			hostRR(j, J_B8, 0x0FB6, RAX, RCX);
+			hostRX(j, 0, 0xC6, 0, J_TMP, RAX, 0);  // mov byte [r14 + rax], PCH
+			hostImm8(j, (insn->pc + 2) >> 8);
+			hostRR(j, J_B8, 0x0FB6, RAX, RDX);
+			hostRX(j, 0, 0xC6, 0, J_TMP, RAX, 0);
+			hostImm8(j, (insn->pc + 2) & 0xFF);
+			hostRM(j, 0, 0x80, 5, J_CPU, OFF(SP));  // sub byte [SP], 2
+			hostImm8(j, 2);
+			jitLeave(j, operand, cycles);
+			j->done = true;
+			break;
+
+		case RTS:
+			hostRM(j, 0, 0x0FB6, RCX, J_CPU, OFF(SP));
+			hostRR(j, J_B8, 0xFE, 0, RCX);
+			hostAlu(j, 1, RCX, 0x100);
+			jitPage(j, J_READ, RDX);
+			hostRR(j, J_B8, 0x0FB6, RAX, RCX);
+			hostRX(j, 0, 0x0FB6, RCX, RDX, RAX, 0);  // ecx = PCL
+			hostRR(j, J_B8, 0xFE, 0, RAX);
+			hostRX(j, 0, 0x0FB6, RAX, RDX, RAX, 0);  // eax = PCH
+			hostShift(j, 4, RAX, 8);
+			hostRR(j, 0, 0x0B, RAX, RCX);
+			hostAlu(j, 0, RAX, 1);
+			hostRM(j, J_W16, 0x89, RAX, J_CPU, OFF(PC));
+			hostRM(j, 0, 0x80, 0, J_CPU, OFF(SP));  // add byte [SP], 2
+			hostImm8(j, 2);
+			jitLeave(j, -1, cycles);
+			j->done = true;
+			break;
+
+		case JMP:
+			if (mode != ABS)
+				return false;
+			jitLeave(j, operand, cycles);
+			j->done = true;
+			break;
+
+		case BPL: case BMI: case BVC: case BVS: case BCC: case BCS: case BNE: case BEQ: {
+			uint16_t next = insn->pc + 2;
+			uint16_t offset = bytes[1] & SIGN ? bytes[1] | 0xFF00 : bytes[1];
+			int taken;
+			if (op == BCC || op == BCS) {
+				hostRR(j, 0, 0x85, J_C, J_C);
+				taken = op == BCS ? J_JNZ : J_JZ;
+			} else if (op == BVC || op == BVS) {
+				hostRM(j, 0, 0xF6, 0, J_CPU, OFF(P));
+				hostImm8(j, OFLOW);
+				taken = op == BVS ? J_JNZ : J_JZ;
+			} else if (op == BPL || op == BMI) {
+				hostRR(j, 0, 0xF7, 0, J_NZ);  // test r12d, 0x180
+				hostImm32(j, 0x180);
+				taken = op == BMI ? J_JNZ : J_JZ;
+			} else {
+				hostRR(j, J_B8, 0x84, J_NZ, J_NZ);  // test r12b, r12b
+				taken = op == BEQ ? J_JZ : J_JNZ;
+			}
+			jitJumpTo(j, taken, next + offset, cycles + 1 + ((((next & 0xFF) + offset) & 0xFF00) != 0));
+			jitLeave(j, next, cycles);
+			j->done = true;
+			break;
+		}
+
+		default:
+			return false;
+	}
+	return true;
+}
+
+
+// drops all the host code when the arena is full
+static void jitFlush(puce6502_t *cpu) {
+	jitArena_t *arena = cpu->jit;
+	for (int i = 0; i < PUCE6502_BLOCKS; i++) {
+		puce6502_block_t *block = &cpu->cache->blocks[i];
+		if (block->native) {
+			block->native = NULL;
+			block->hits = 0;
+		}
+	}
+	arena->used = 0;
+}
+
+static void jitCompile(puce6502_t *cpu, puce6502_block_t *block) {
+	static const int saved[] = { RBX, RBP, RSI, RDI, R12, R13, R14, R15 };
+	jitArena_t *arena = cpu->jit;
+
+	if (!arena) {
+		arena = cpu->jit = calloc(1, sizeof(jitArena_t));
+		if (!arena)
+			return;
+#ifdef _WIN32
+		arena->code = VirtualAlloc(NULL, JIT_ARENA, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+		arena->code = mmap(NULL, JIT_ARENA, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (arena->code == MAP_FAILED)
+			arena->code = NULL;
+#endif
+	}
+	if (!cpu->readPages || !cpu->writePages || !arena->code)
+		return;
+	if (arena->used + JIT_BLOCK_MAX > JIT_ARENA)
+		jitFlush(cpu);
+
+	jit_t jit = { .cpu = cpu, .p = arena->code + arena->used };
+	jit_t *j = &jit;
+
+	// epilogue first, the block's exits all jump back to it
+	j->epilogue = j->p;
+	hostRM(j, J_B8, 0x88, J_A, J_CPU, OFF(A));
+	hostRM(j, J_B8, 0x88, J_X, J_CPU, OFF(X));
+	hostRM(j, J_B8, 0x88, J_Y, J_CPU, OFF(Y));
+	hostAluP(j, 4, (uint8_t)~CARRY);
+	hostRM(j, J_B8, 0x08, J_C, J_CPU, OFF(P));
+	hostRM(j, J_W16, 0x89, J_NZ, J_CPU, OFF(NZ));
+	hostRM(j, J_W64, 0x01, J_TICKS, J_CPU, OFF(ticks));
+	for (int i = 7; i >= 0; i--)
+		hostPop(j, saved[i]);
+	hostImm8(j, 0xC3);  // ret
+
+	// entry point
+	uint8_t *entry = j->p;
+	for (int i = 0; i < 8; i++)
+		hostPush(j, saved[i]);
+#ifdef _WIN32
+	hostRR(j, J_W64, 0x8B, J_CPU, RCX);
+#else
+	hostRR(j, J_W64, 0x8B, J_CPU, RDI);
+#endif
+	hostRM(j, J_W64, 0x8B, J_READ, J_CPU, OFF(cpu->readPages));
+	hostRM(j, J_W64, 0x8B, J_WRITE, J_CPU, OFF(cpu->writePages));
+	hostRM(j, J_W64, 0x8B, J_CODE, J_CPU, OFF(cpu->cache));
+	hostRR(j, J_W64, 0x81, 0, J_CODE);
+	hostImm32(j, offsetof(puce6502_cache_t, code));
+	hostRM(j, 0, 0x0FB6, J_A, J_CPU, OFF(A));
+	hostRM(j, 0, 0x0FB6, J_X, J_CPU, OFF(X));
+	hostRM(j, 0, 0x0FB6, J_Y, J_CPU, OFF(Y));
+	hostRM(j, 0, 0x0FB7, J_NZ, J_CPU, OFF(NZ));
+	hostRM(j, 0, 0x0FB6, J_C, J_CPU, OFF(P));
+	hostAlu(j, 4, J_C, CARRY);
+	hostRR(j, 0, 0x33, J_TICKS, J_TICKS);
+
+	int count = 0;
+	for (; count < block->count && !j->done; count++) {
+		const puce6502_insn_t *insn = &block->insn[count];
+		j->pc = insn->pc;
+		if (!jitInstruction(j, insn))
+			break;
+		j->cycles += jitOpcodes[insn->bytes[0]].cycles;
+	}
+	if (!count)
+		return;  // nothing worth it, the arena space is reused
+	if (!j->done) {
+		const puce6502_insn_t *last = &block->insn[count - 1];
+		jitLeave(j, count < block->count ? block->insn[count].pc : last->pc + insnLength[last->bytes[0]], j->cycles);
+	}
+
+	for (int i = 0; i < j->exits; i++) {
+		hostPatch(j->exit[i].jump, j->p);
+		jitLeave(j, j->exit[i].pc, j->exit[i].cycles);
+	}
+
+	arena->used = j->p - arena->code;
+	memcpy(&block->native, &entry, sizeof(entry));  // ISO C has no data to function pointer cast
+}
+
+#undef OFF
+
+#endif
@@ -0,0 +1,307 @@
+/*
+  Puce6502 - opcode table
+
+  Every opcode of the NMOS 6502 and of the 65C02, one line each : mnemonic,
+  addressing mode, cycles, one more cycle when indexing crosses a page, and
+  the CPUs running it (ALL, NMOS or CMOS). An opcode whose timing differs on
+  the two CPUs has a line for each.
+
+  puce6502.c expands PUCE6502_OPCODES() into its instructions, disassembler
+  and block cache tables, each line through ON_ALL(), ON_NMOS() or ON_CMOS()
+  which drop the ones of the other CPU : the core is the NMOS 6502 by
+  default and the 65C02 when built with PUCE6502_CMOS (see puce65c02.c).
+  RMB, SMB, BBR and BBS take the number of their bit from the opcode. The
+  NMOS undocumented opcodes are missing, the core runs them as 1 byte NOPs.
+  The undefined 65C02 opcodes are NOPs with their own lengths and cycles, 1
+  for the one byte ones ($x3 and $xB).
+*/
+
+#ifndef _PUCE6502OPS_H
+#define _PUCE6502OPS_H
+
+// addressing modes, by instruction length : 1, 2 then 3 bytes
+enum { IMP, ACC, IMM, ZPG, ZPX, ZPY, REL, IZP, IZX, IZY, ABS, ABX, ABY, IND, IAX, ZPR };
+
+#define LENGTH(mode) ((mode) < IMM ? 1 : (mode) < ABS ? 2 : 3)
+
+enum {  // mnemonics
+	ADC, AND, ASL, BBR, BBS, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRA, BRK,
+	BVC, BVS, CLC, CLD, CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR, INC,
+	INX, INY, JMP, JSR, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PHX, PHY,
+	PLA, PLP, PLX, PLY, RMB, ROL, ROR, RTI, RTS, SBC, SEC, SED, SEI, SMB,
+	STA, STP, STX, STY, STZ, TAX, TAY, TRB, TSB, TSX, TXA, TXS, TYA, WAI };
+
+#define ON_ALL(...) __VA_ARGS__
+
+#ifdef PUCE6502_CMOS
+	#define ON_NMOS(...)
+	#define ON_CMOS(...) __VA_ARGS__
+#else
+	#define ON_NMOS(...) __VA_ARGS__
+	#define ON_CMOS(...)
+#endif
+
+// OP(opcode, mnemonic, mode, cycles, cross, cpus)
+#define PUCE6502_OPCODES(OP) \
+	OP(0x00, BRK, IMP, 7, 0, ALL) \
+	OP(0x01, ORA, IZX, 6, 0, ALL) \
+	OP(0x02, NOP, IMM, 2, 0, CMOS) \
+	OP(0x03, NOP, IMP, 1, 0, CMOS) \
+	OP(0x04, TSB, ZPG, 5, 0, CMOS) \
+	OP(0x05, ORA, ZPG, 3, 0, ALL) \
+	OP(0x06, ASL, ZPG, 5, 0, ALL) \
+	OP(0x07, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x08, PHP, IMP, 3, 0, ALL) \
+	OP(0x09, ORA, IMM, 2, 0, ALL) \
+	OP(0x0A, ASL, ACC, 2, 0, ALL) \
+	OP(0x0B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x0C, TSB, ABS, 6, 0, CMOS) \
+	OP(0x0D, ORA, ABS, 4, 0, ALL) \
+	OP(0x0E, ASL, ABS, 6, 0, ALL) \
+	OP(0x0F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x10, BPL, REL, 2, 0, ALL) \
+	OP(0x11, ORA, IZY, 5, 1, ALL) \
+	OP(0x12, ORA, IZP, 5, 0, CMOS) \
+	OP(0x13, NOP, IMP, 1, 0, CMOS) \
+	OP(0x14, TRB, ZPG, 5, 0, CMOS) \
+	OP(0x15, ORA, ZPX, 4, 0, ALL) \
+	OP(0x16, ASL, ZPX, 6, 0, ALL) \
+	OP(0x17, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x18, CLC, IMP, 2, 0, ALL) \
+	OP(0x19, ORA, ABY, 4, 1, ALL) \
+	OP(0x1A, INC, ACC, 2, 0, CMOS) \
+	OP(0x1B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x1C, TRB, ABS, 6, 0, CMOS) \
+	OP(0x1D, ORA, ABX, 4, 1, ALL) \
+	OP(0x1E, ASL, ABX, 7, 0, NMOS) \
+	OP(0x1E, ASL, ABX, 6, 1, CMOS) \
+	OP(0x1F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x20, JSR, ABS, 6, 0, ALL) \
+	OP(0x21, AND, IZX, 6, 0, ALL) \
+	OP(0x22, NOP, IMM, 2, 0, CMOS) \
+	OP(0x23, NOP, IMP, 1, 0, CMOS) \
+	OP(0x24, BIT, ZPG, 3, 0, ALL) \
+	OP(0x25, AND, ZPG, 3, 0, ALL) \
+	OP(0x26, ROL, ZPG, 5, 0, ALL) \
+	OP(0x27, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x28, PLP, IMP, 4, 0, ALL) \
+	OP(0x29, AND, IMM, 2, 0, ALL) \
+	OP(0x2A, ROL, ACC, 2, 0, ALL) \
+	OP(0x2B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x2C, BIT, ABS, 4, 0, ALL) \
+	OP(0x2D, AND, ABS, 4, 0, ALL) \
+	OP(0x2E, ROL, ABS, 6, 0, ALL) \
+	OP(0x2F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x30, BMI, REL, 2, 0, ALL) \
+	OP(0x31, AND, IZY, 5, 1, ALL) \
+	OP(0x32, AND, IZP, 5, 0, CMOS) \
+	OP(0x33, NOP, IMP, 1, 0, CMOS) \
+	OP(0x34, BIT, ZPX, 4, 0, CMOS) \
+	OP(0x35, AND, ZPX, 4, 0, ALL) \
+	OP(0x36, ROL, ZPX, 6, 0, ALL) \
+	OP(0x37, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x38, SEC, IMP, 2, 0, ALL) \
+	OP(0x39, AND, ABY, 4, 1, ALL) \
+	OP(0x3A, DEC, ACC, 2, 0, CMOS) \
+	OP(0x3B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x3C, BIT, ABX, 4, 1, CMOS) \
+	OP(0x3D, AND, ABX, 4, 1, ALL) \
+	OP(0x3E, ROL, ABX, 7, 0, NMOS) \
+	OP(0x3E, ROL, ABX, 6, 1, CMOS) \
+	OP(0x3F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x40, RTI, IMP, 6, 0, ALL) \
+	OP(0x41, EOR, IZX, 6, 0, ALL) \
+	OP(0x42, NOP, IMM, 2, 0, CMOS) \
+	OP(0x43, NOP, IMP, 1, 0, CMOS) \
+	OP(0x44, NOP, ZPG, 3, 0, CMOS) \
+	OP(0x45, EOR, ZPG, 3, 0, ALL) \
+	OP(0x46, LSR, ZPG, 5, 0, ALL) \
+	OP(0x47, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x48, PHA, IMP, 3, 0, ALL) \
+	OP(0x49, EOR, IMM, 2, 0, ALL) \
+	OP(0x4A, LSR, ACC, 2, 0, ALL) \
+	OP(0x4B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x4C, JMP, ABS, 3, 0, ALL) \
+	OP(0x4D, EOR, ABS, 4, 0, ALL) \
+	OP(0x4E, LSR, ABS, 6, 0, ALL) \
+	OP(0x4F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x50, BVC, REL, 2, 0, ALL) \
+	OP(0x51, EOR, IZY, 5, 1, ALL) \
+	OP(0x52, EOR, IZP, 5, 0, CMOS) \
+	OP(0x53, NOP, IMP, 1, 0, CMOS) \
+	OP(0x54, NOP, ZPX, 4, 0, CMOS) \
+	OP(0x55, EOR, ZPX, 4, 0, ALL) \
+	OP(0x56, LSR, ZPX, 6, 0, ALL) \
+	OP(0x57, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x58, CLI, IMP, 2, 0, ALL) \
+	OP(0x59, EOR, ABY, 4, 1, ALL) \
+	OP(0x5A, PHY, IMP, 3, 0, CMOS) \
+	OP(0x5B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x5C, NOP, ABS, 8, 0, CMOS) \
+	OP(0x5D, EOR, ABX, 4, 1, ALL) \
+	OP(0x5E, LSR, ABX, 7, 0, NMOS) \
+	OP(0x5E, LSR, ABX, 6, 1, CMOS) \
+	OP(0x5F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x60, RTS, IMP, 6, 0, ALL) \
+	OP(0x61, ADC, IZX, 6, 0, ALL) \
+	OP(0x62, NOP, IMM, 2, 0, CMOS) \
+	OP(0x63, NOP, IMP, 1, 0, CMOS) \
+	OP(0x64, STZ, ZPG, 3, 0, CMOS) \
+	OP(0x65, ADC, ZPG, 3, 0, ALL) \
+	OP(0x66, ROR, ZPG, 5, 0, ALL) \
+	OP(0x67, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x68, PLA, IMP, 4, 0, ALL) \
+	OP(0x69, ADC, IMM, 2, 0, ALL) \
+	OP(0x6A, ROR, ACC, 2, 0, ALL) \
+	OP(0x6B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x6C, JMP, IND, 5, 0, ALL) \
+	OP(0x6D, ADC, ABS, 4, 0, ALL) \
+	OP(0x6E, ROR, ABS, 6, 0, ALL) \
+	OP(0x6F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x70, BVS, REL, 2, 0, ALL) \
+	OP(0x71, ADC, IZY, 5, 1, ALL) \
+	OP(0x72, ADC, IZP, 5, 0, CMOS) \
+	OP(0x73, NOP, IMP, 1, 0, CMOS) \
+	OP(0x74, STZ, ZPX, 4, 0, CMOS) \
+	OP(0x75, ADC, ZPX, 4, 0, ALL) \
+	OP(0x76, ROR, ZPX, 6, 0, ALL) \
+	OP(0x77, RMB, ZPG, 5, 0, CMOS) \
+	OP(0x78, SEI, IMP, 2, 0, ALL) \
+	OP(0x79, ADC, ABY, 4, 1, ALL) \
+	OP(0x7A, PLY, IMP, 4, 0, CMOS) \
+	OP(0x7B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x7C, JMP, IAX, 6, 0, CMOS) \
+	OP(0x7D, ADC, ABX, 4, 1, ALL) \
+	OP(0x7E, ROR, ABX, 7, 0, NMOS) \
+	OP(0x7E, ROR, ABX, 6, 1, CMOS) \
+	OP(0x7F, BBR, ZPR, 5, 0, CMOS) \
+	OP(0x80, BRA, REL, 2, 0, CMOS) \
+	OP(0x81, STA, IZX, 6, 0, ALL) \
+	OP(0x82, NOP, IMM, 2, 0, CMOS) \
+	OP(0x83, NOP, IMP, 1, 0, CMOS) \
+	OP(0x84, STY, ZPG, 3, 0, ALL) \
+	OP(0x85, STA, ZPG, 3, 0, ALL) \
+	OP(0x86, STX, ZPG, 3, 0, ALL) \
+	OP(0x87, SMB, ZPG, 5, 0, CMOS) \
+	OP(0x88, DEY, IMP, 2, 0, ALL) \
+	OP(0x89, BIT, IMM, 2, 0, CMOS) \
+	OP(0x8A, TXA, IMP, 2, 0, ALL) \
+	OP(0x8B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x8C, STY, ABS, 4, 0, ALL) \
+	OP(0x8D, STA, ABS, 4, 0, ALL) \
+	OP(0x8E, STX, ABS, 4, 0, ALL) \
+	OP(0x8F, BBS, ZPR, 5, 0, CMOS) \
+	OP(0x90, BCC, REL, 2, 0, ALL) \
+	OP(0x91, STA, IZY, 6, 0, ALL) \
+	OP(0x92, STA, IZP, 5, 0, CMOS) \
+	OP(0x93, NOP, IMP, 1, 0, CMOS) \
+	OP(0x94, STY, ZPX, 4, 0, ALL) \
+	OP(0x95, STA, ZPX, 4, 0, ALL) \
+	OP(0x96, STX, ZPY, 4, 0, ALL) \
+	OP(0x97, SMB, ZPG, 5, 0, CMOS) \
+	OP(0x98, TYA, IMP, 2, 0, ALL) \
+	OP(0x99, STA, ABY, 5, 0, ALL) \
+	OP(0x9A, TXS, IMP, 2, 0, ALL) \
+	OP(0x9B, NOP, IMP, 1, 0, CMOS) \
+	OP(0x9C, STZ, ABS, 4, 0, CMOS) \
+	OP(0x9D, STA, ABX, 5, 0, ALL) \
+	OP(0x9E, STZ, ABX, 5, 1, CMOS) \
+	OP(0x9F, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xA0, LDY, IMM, 2, 0, ALL) \
+	OP(0xA1, LDA, IZX, 6, 0, ALL) \
+	OP(0xA2, LDX, IMM, 2, 0, ALL) \
+	OP(0xA3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xA4, LDY, ZPG, 3, 0, ALL) \
+	OP(0xA5, LDA, ZPG, 3, 0, ALL) \
+	OP(0xA6, LDX, ZPG, 3, 0, ALL) \
+	OP(0xA7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xA8, TAY, IMP, 2, 0, ALL) \
+	OP(0xA9, LDA, IMM, 2, 0, ALL) \
+	OP(0xAA, TAX, IMP, 2, 0, ALL) \
+	OP(0xAB, NOP, IMP, 1, 0, CMOS) \
+	OP(0xAC, LDY, ABS, 4, 0, ALL) \
+	OP(0xAD, LDA, ABS, 4, 0, ALL) \
+	OP(0xAE, LDX, ABS, 4, 0, ALL) \
+	OP(0xAF, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xB0, BCS, REL, 2, 0, ALL) \
+	OP(0xB1, LDA, IZY, 5, 1, ALL) \
+	OP(0xB2, LDA, IZP, 5, 0, CMOS) \
+	OP(0xB3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xB4, LDY, ZPX, 4, 0, ALL) \
+	OP(0xB5, LDA, ZPX, 4, 0, ALL) \
+	OP(0xB6, LDX, ZPY, 4, 0, ALL) \
+	OP(0xB7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xB8, CLV, IMP, 2, 0, ALL) \
+	OP(0xB9, LDA, ABY, 4, 1, ALL) \
+	OP(0xBA, TSX, IMP, 2, 0, ALL) \
+	OP(0xBB, NOP, IMP, 1, 0, CMOS) \
+	OP(0xBC, LDY, ABX, 4, 1, ALL) \
+	OP(0xBD, LDA, ABX, 4, 1, ALL) \
+	OP(0xBE, LDX, ABY, 4, 1, ALL) \
+	OP(0xBF, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xC0, CPY, IMM, 2, 0, ALL) \
+	OP(0xC1, CMP, IZX, 6, 0, ALL) \
+	OP(0xC2, NOP, IMM, 2, 0, CMOS) \
+	OP(0xC3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xC4, CPY, ZPG, 3, 0, ALL) \
+	OP(0xC5, CMP, ZPG, 3, 0, ALL) \
+	OP(0xC6, DEC, ZPG, 5, 0, ALL) \
+	OP(0xC7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xC8, INY, IMP, 2, 0, ALL) \
+	OP(0xC9, CMP, IMM, 2, 0, ALL) \
+	OP(0xCA, DEX, IMP, 2, 0, ALL) \
+	OP(0xCB, WAI, IMP, 3, 0, CMOS) \
+	OP(0xCC, CPY, ABS, 4, 0, ALL) \
+	OP(0xCD, CMP, ABS, 4, 0, ALL) \
+	OP(0xCE, DEC, ABS, 6, 0, ALL) \
+	OP(0xCF, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xD0, BNE, REL, 2, 0, ALL) \
+	OP(0xD1, CMP, IZY, 5, 1, ALL) \
+	OP(0xD2, CMP, IZP, 5, 0, CMOS) \
+	OP(0xD3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xD4, NOP, ZPX, 4, 0, CMOS) \
+	OP(0xD5, CMP, ZPX, 4, 0, ALL) \
+	OP(0xD6, DEC, ZPX, 6, 0, ALL) \
+	OP(0xD7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xD8, CLD, IMP, 2, 0, ALL) \
+	OP(0xD9, CMP, ABY, 4, 1, ALL) \
+	OP(0xDA, PHX, IMP, 3, 0, CMOS) \
+	OP(0xDB, STP, IMP, 3, 0, CMOS) \
+	OP(0xDC, NOP, ABS, 4, 0, CMOS) \
+	OP(0xDD, CMP, ABX, 4, 1, ALL) \
+	OP(0xDE, DEC, ABX, 7, 0, ALL) \
+	OP(0xDF, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xE0, CPX, IMM, 2, 0, ALL) \
+	OP(0xE1, SBC, IZX, 6, 0, ALL) \
+	OP(0xE2, NOP, IMM, 2, 0, CMOS) \
+	OP(0xE3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xE4, CPX, ZPG, 3, 0, ALL) \
+	OP(0xE5, SBC, ZPG, 3, 0, ALL) \
+	OP(0xE6, INC, ZPG, 5, 0, ALL) \
+	OP(0xE7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xE8, INX, IMP, 2, 0, ALL) \
+	OP(0xE9, SBC, IMM, 2, 0, ALL) \
+	OP(0xEA, NOP, IMP, 2, 0, ALL) \
+	OP(0xEB, NOP, IMP, 1, 0, CMOS) \
+	OP(0xEC, CPX, ABS, 4, 0, ALL) \
+	OP(0xED, SBC, ABS, 4, 0, ALL) \
+	OP(0xEE, INC, ABS, 6, 0, ALL) \
+	OP(0xEF, BBS, ZPR, 5, 0, CMOS) \
+	OP(0xF0, BEQ, REL, 2, 0, ALL) \
+	OP(0xF1, SBC, IZY, 5, 1, ALL) \
+	OP(0xF2, SBC, IZP, 5, 0, CMOS) \
+	OP(0xF3, NOP, IMP, 1, 0, CMOS) \
+	OP(0xF4, NOP, ZPX, 4, 0, CMOS) \
+	OP(0xF5, SBC, ZPX, 4, 0, ALL) \
+	OP(0xF6, INC, ZPX, 6, 0, ALL) \
+	OP(0xF7, SMB, ZPG, 5, 0, CMOS) \
+	OP(0xF8, SED, IMP, 2, 0, ALL) \
+	OP(0xF9, SBC, ABY, 4, 1, ALL) \
+	OP(0xFA, PLX, IMP, 4, 0, CMOS) \
+	OP(0xFB, NOP, IMP, 1, 0, CMOS) \
+	OP(0xFC, NOP, ABS, 4, 0, CMOS) \
+	OP(0xFD, SBC, ABX, 4, 1, ALL) \
+	OP(0xFE, INC, ABX, 7, 0, ALL) \
+	OP(0xFF, BBS, ZPR, 5, 0, CMOS)
+
+#endif
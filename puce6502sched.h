@@ -0,0 +1,110 @@
+/*
+  Puce6502 - device events on the CPU cycle counter
+
+  Devices give the ticks value their next event is due at and schedRun() runs
+  the CPU straight to the earliest one, fires it, and goes on : nothing is
+  polled between two instructions and the events not pending cost nothing.
+  The pending ones are kept in a binary heap, the earliest on top.
+
+  An event fires once ticks reached its due time, at most one instruction
+  late. One scheduled while the CPU runs (from a soft switch access) is only
+  seen when that run ends, so what the CPU reads back from a device must be
+  computed from ticks, as the paddles do.
+*/
+
+#ifndef _PUCE6502SCHED_H
+#define _PUCE6502SCHED_H
+
+#include "puce6502.h"
+
+#define SCHED_EVENTS 8  // distinct events, numbered from 0 by the machine
+
+typedef void (*schedHandler_t)(unsigned long long int due);  // given the ticks value it was due at
+
+typedef struct {
+	unsigned long long int due[SCHED_EVENTS];  // ticks value of each event
+	schedHandler_t handler[SCHED_EVENTS];
+	int heap[SCHED_EVENTS];  // the pending events, heap[0] is the earliest
+	int slot[SCHED_EVENTS];  // where each event is in heap[], -1 when not pending
+	int count;  // pending events
+} sched_t;
+
+
+static inline void schedInit(sched_t *sched) {
+	sched->count = 0;
+	for (int event = 0; event < SCHED_EVENTS; event++)
+		sched->slot[event] = -1;
+}
+
+static inline int schedEarlier(const sched_t *sched, int a, int b) {  // heap positions
+	return sched->due[sched->heap[a]] < sched->due[sched->heap[b]];
+}
+
+static inline void schedSwap(sched_t *sched, int a, int b) {
+	int event = sched->heap[a];
+	sched->heap[a] = sched->heap[b];
+	sched->heap[b] = event;
+	sched->slot[sched->heap[a]] = a;
+	sched->slot[sched->heap[b]] = b;
+}
+
+// moves the event at position i up or down to its place
+static inline void schedSift(sched_t *sched, int i) {
+	while (i > 0 && schedEarlier(sched, i, (i - 1) / 2)) {
+		schedSwap(sched, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	for (;;) {
+		int first = i, left = 2 * i + 1, right = 2 * i + 2;
+		if (left < sched->count && schedEarlier(sched, left, first))
+			first = left;
+		if (right < sched->count && schedEarlier(sched, right, first))
+			first = right;
+		if (first == i)
+			return;
+		schedSwap(sched, i, first);
+		i = first;
+	}
+}
+
+// event is due at that ticks value, moved there if it was already pending
+static inline void schedAt(sched_t *sched, int event, unsigned long long int due, schedHandler_t handler) {
+	sched->due[event] = due;
+	sched->handler[event] = handler;
+	if (sched->slot[event] < 0) {
+		sched->slot[event] = sched->count;
+		sched->heap[sched->count++] = event;
+	}
+	schedSift(sched, sched->slot[event]);
+}
+
+static inline void schedCancel(sched_t *sched, int event) {
+	int i = sched->slot[event];
+	if (i < 0)
+		return;
+	sched->slot[event] = -1;
+	if (i != --sched->count) {  // the last one takes its place
+		sched->heap[i] = sched->heap[sched->count];
+		sched->slot[sched->heap[i]] = i;
+		schedSift(sched, i);
+	}
+}
+
+// runs the CPU until ticks reaches until, firing the events due on the way
+static inline void schedRun(sched_t *sched, puce6502_t *cpu, unsigned long long int until) {
+	while (cpu->ticks < until) {
+		unsigned long long int next = until;
+		if (sched->count && sched->due[sched->heap[0]] < next)
+			next = sched->due[sched->heap[0]];
+		if (cpu->ticks < next)
+			puce6502Exec(cpu, next - cpu->ticks);
+
+		while (sched->count && sched->due[sched->heap[0]] <= cpu->ticks) {
+			int event = sched->heap[0];
+			schedCancel(sched, event);
+			sched->handler[event](sched->due[event]);  // may schedule it again
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+  Puce6502 - instruction trace decoder
+
+  Disassembles the file written by puce6502TraceSave(), oldest instruction
+  first : the cores only copy a few bytes per instruction into their ring and
+  leave the text to this program, off line.
+
+  usage : puce6502trace trace.bin [records]
+  prints the last records of the trace, all of them by default. One line per
+  instruction : cycle, address, bytes, disassembly and the registers before
+  it ran.
+
+  built on its own : cc -O2 -o puce6502trace puce6502trace.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puce6502.h"
+#include "puce6502ops.h"
+
+// the opcode table of each CPU, whatever the core was built for
+#define NMOS_ALL(...)  __VA_ARGS__
+#define NMOS_NMOS(...) __VA_ARGS__
+#define NMOS_CMOS(...)
+#define CMOS_ALL(...)  __VA_ARGS__
+#define CMOS_NMOS(...)
+#define CMOS_CMOS(...) __VA_ARGS__
+
+#define NMOS_OPCODE(opcode, mnemonic, mode, clocks, cross, cpus) NMOS_##cpus([opcode] = { #mnemonic, mode },)
+#define CMOS_OPCODE(opcode, mnemonic, mode, clocks, cross, cpus) CMOS_##cpus([opcode] = { #mnemonic, mode },)
+
+typedef struct {
+	const char *name;  // NULL for the undefined opcodes
+	int mode;
+} opcode_t;
+
+static const opcode_t nmos[256] = { PUCE6502_OPCODES(NMOS_OPCODE) };
+static const opcode_t cmos[256] = { PUCE6502_OPCODES(CMOS_OPCODE) };
+
+
+static void decode(const opcode_t *opcodes, const puce6502_record_t *record, char *buffer) {
+	uint8_t op = record->bytes[0], b1 = record->bytes[1], b2 = record->bytes[2];
+	uint16_t next = record->pc + 2;  // relative branches
+	char name[8] = "???";
+
+	if (opcodes[op].name) {
+		strcpy(name, opcodes[op].name);
+		if (!strcmp(name, "RMB") || !strcmp(name, "SMB") || !strcmp(name, "BBR") || !strcmp(name, "BBS"))
+			sprintf(name + 3, "%d", (op >> 4) & 7);  // bit number
+	}
+
+	switch (opcodes[op].name ? opcodes[op].mode : IMP) {
+		case IMP: sprintf(buffer, "%02X        %s",               op,       name); break;
+		case ACC: sprintf(buffer, "%02X        %s A",             op,       name); break;
+		case IMM: sprintf(buffer, "%02X %02X     %s #$%02X",      op,b1,    name,b1); break;
+		case ZPG: sprintf(buffer, "%02X %02X     %s $%02X",       op,b1,    name,b1); break;
+		case ZPX: sprintf(buffer, "%02X %02X     %s $%02X,X",     op,b1,    name,b1); break;
+		case ZPY: sprintf(buffer, "%02X %02X     %s $%02X,Y",     op,b1,    name,b1); break;
+		case REL: sprintf(buffer, "%02X %02X     %s $%04X",       op,b1,    name,(uint16_t)(next + (int8_t)b1)); break;
+		case IZP: sprintf(buffer, "%02X %02X     %s ($%02X)",     op,b1,    name,b1); break;
+		case IZX: sprintf(buffer, "%02X %02X     %s ($%02X,X)",   op,b1,    name,b1); break;
+		case IZY: sprintf(buffer, "%02X %02X     %s ($%02X),Y",   op,b1,    name,b1); break;
+		case ABS: sprintf(buffer, "%02X %02X %02X  %s $%02X%02X",     op,b1,b2, name,b2,b1); break;
+		case ABX: sprintf(buffer, "%02X %02X %02X  %s $%02X%02X,X",   op,b1,b2, name,b2,b1); break;
+		case ABY: sprintf(buffer, "%02X %02X %02X  %s $%02X%02X,Y",   op,b1,b2, name,b2,b1); break;
+		case IND: sprintf(buffer, "%02X %02X %02X  %s ($%02X%02X)",   op,b1,b2, name,b2,b1); break;
+		case IAX: sprintf(buffer, "%02X %02X %02X  %s ($%02X%02X,X)", op,b1,b2, name,b2,b1); break;
+		case ZPR: sprintf(buffer, "%02X %02X %02X  %s $%02X,$%04X",   op,b1,b2, name,b1,(uint16_t)(next + 1 + (int8_t)b2)); break;
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "usage : %s trace.bin [records]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (!file) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	puce6502_trace_header_t header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, PUCE6502_TRACE_MAGIC, sizeof(header.magic))) {
+		fprintf(stderr, "%s : not a puce6502 trace\n", argv[1]);
+		return 1;
+	}
+	const opcode_t *opcodes = header.cpu == 0x65C02 ? cmos : nmos;
+
+	uint32_t skip = 0;  // the records before the last ones asked for
+	if (argc > 2 && (uint32_t)atol(argv[2]) < header.records)
+		skip = header.records - atol(argv[2]);
+	fseek(file, skip * (long)sizeof(puce6502_record_t), SEEK_CUR);
+
+	puce6502_record_t record;
+	char text[64];
+	for (uint32_t i = skip; i < header.records && fread(&record, sizeof(record), 1, file) == 1; i++) {
+		decode(opcodes, &record, text);
+		printf("%10u  %04X: %-26s A=%02X X=%02X Y=%02X S=%02X %c%c%c%c%c%c%c%c\n",
+			record.cycle, record.pc, text, record.a, record.x, record.y, record.sp,
+			record.p & 0x80 ? 'N' : '-', record.p & 0x40 ? 'V' : '-', record.p & 0x20 ? 'U' : '.',
+			record.p & 0x10 ? 'B' : '-', record.p & 0x08 ? 'D' : '-', record.p & 0x04 ? 'I' : '-',
+			record.p & 0x02 ? 'Z' : '-', record.p & 0x01 ? 'C' : '-');
+	}
+
+	fclose(file);
+	return 0;
+}
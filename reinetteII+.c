@@ -31,6 +31,15 @@
 #include <SDL2/SDL.h>
 
 #include "puce6502.h"
+#include "puce6502sched.h"
+#include "reinetteslot.h"
+#ifdef PUCE6502_TRACE
+#include <signal.h>
+#include <stdlib.h>
+#endif
+#ifdef PUCE6502_PROFILE
+#include <stdlib.h>
+#endif
 #include "dsk2nib.h"
 #include "nib2dsk.h"
 
@@ -56,6 +65,11 @@ int debug=0;
 #define SCREEN_RES_H	192
 #define SCREEN_BPP		8
 
+// the 6502, its memory callbacks are set by SysInit()
+puce6502_t cpu;
+sched_t sched;																	// device events, see puce6502sched.h
+enum { EVENT_SLOT1 };															// then one per slot, see slotAt()
+
 // memory layout
 #define RAMSIZE	 0xC000
 #define ROMSTART 0xD000
@@ -93,32 +107,81 @@ bool LCBK2 = true;// Language Card bank 2 enabled
 bool LCWFF = false;// Language Card pre-write flip flop
 
 
+//================================================================== PAGE TABLES
+// one entry per 256 bytes page, pointing straight into ram, rom, lgc, bk2 or a card's ROM
+// a NULL entry marks an I/O page, accesses to it are sent to softSwitches()
+
+uint8_t *readPages[256];														// where CPU reads of each page go
+uint8_t *writePages[256];														// where CPU writes of each page go
+uint8_t romSink[256];															// swallows writes to ROM
+uint8_t videoDirty[0x10000 >> 7];												// 128 bytes blocks written since the last frame
+#ifdef PUCE6502_CACHE
+puce6502_cache_t cache;															// predecoded 6502 code, see puce6502cache.h
+#endif
+#ifdef PUCE6502_IDLE
+puce6502_idle_t idle;															// loops waiting for a key, see puce6502.c
+#endif
+#ifdef PUCE6502_TRACE
+puce6502_trace_t *trace;														// last instructions run, see puce6502trace.c
+#endif
+#ifdef PUCE6502_PROFILE
+puce6502_profile_t *profile;													// cycles spent per address and per subroutine
+#endif
+#ifdef PUCE6502_TRAPS
+puce6502_traps_t traps;															// monitor routines done at once, see trapWait()
+#endif
+#ifdef PUCE6502_STATS
+puce6502_stats_t stats;															// runs of each opcode, see puce6502StatsSave()
+#endif
+
+void mapLanguageCard() {														// only rebuilds $D000-$FFFF
+	for (int page = 0xD0; page <= 0xFF; page++) {
+		int off = (page - 0xD0) << 8;
+		uint8_t *lc = (LCBK2 && page < 0xE0) ? bk2 + off : lgc + off;			// BK2 or LC
+		if (readPages[page] != (LCRD ? lc : rom + off))
+			puce6502CacheInvalidate(&cpu, page << 8, page << 8 | 0xFF);			// code seen there changed
+		readPages[page]  = LCRD ? lc : rom + off;
+		writePages[page] = LCWR ? lc : romSink;
+#ifdef PUCE6502_PROFILE
+		if (profile)
+			profile->bank[page] = LCRD ? (LCBK2 && page < 0xE0) ? 2 : 1 : 0;	// ROM, LC or BK2
+#endif
+	}
+#ifdef PUCE6502_TRAPS
+	for (int i = 0; i < traps.count; i++)
+		traps.mapped[traps.trap[i].address >> 8] = !LCRD;						// not when the LC replaces the ROM
+#endif
+}
+
+void initPages() {
+	for (int page = 0x00; page < 0xC0; page++)									// 48K of RAM
+		readPages[page] = writePages[page] = ram + (page << 8);
+	for (int page = 0xC0; page < 0xD0; page++)									// soft switches and slots
+		readPages[page] = writePages[page] = NULL;
+	mapLanguageCard();
+}
+
+
 //====================================================================== PADDLES
 
 uint8_t PB0 = 0;// $C061 Push Button 0 (bit 7) / Open Apple
 uint8_t PB1 = 0;// $C062 Push Button 1 (bit 7) / Solid Apple
 uint8_t PB2 = 0;// $C063 Push Button 2 (bit 7) / shift mod !!!
 float GCP[2] = { 127.0f, 127.0f };												// GC Position ranging from 0 (left) to 255 right
-float GCC[2] = { 0.0f };														// $C064 (GC0) and $C065 (GC1) Countdowns
+unsigned long long int GCEnd[2];												// $C064 (GC0) and $C065 (GC1) Countdowns end, in ticks
 int GCD[2] = { 0 };// GC0 and GC1 Directions (left/down or right/up)
 int GCA[2] = { 0 };// GC0 and GC1 Action (push or release)
 uint8_t GCActionSpeed = 8;														// Game Controller speed at which it goes to the edges
 uint8_t GCReleaseSpeed = 8;														// Game Controller speed at which it returns to center
-long long int GCCrigger;														// $C070 the tick at which the GCs were reseted
+#define GCCycles 11																// per position unit, a turn of the monitor's PREAD loop
 
-inline static void resetPaddles() {
-	GCC[0] = GCP[0] * GCP[0];													// initialize the countdown for both paddles
-	GCC[1] = GCP[1] * GCP[1];													// to the square of their actuall values (positions)
-	GCCrigger = ticks;															// records the time this was done
+inline static void resetPaddles() {											// $C070 starts both countdowns
+	GCEnd[0] = cpu.ticks + (unsigned long long int)GCP[0] * GCCycles;			// which last as long as the paddle
+	GCEnd[1] = cpu.ticks + (unsigned long long int)GCP[1] * GCCycles;			// positions
 }
 
 inline static uint8_t readPaddle(int pdl) {
-	const float GCFreq = 6.6;													// the speed at which the GC values decrease
-
-	GCC[pdl] -= (ticks - GCCrigger) / GCFreq;									// decreases the countdown
-	if (GCC[pdl] <= 0)															// timeout
-		return GCC[pdl] = 0;														// returns 0
-	return 0x80;	// not timeout, return something with the MSB set
+	return cpu.ticks < GCEnd[pdl] ? 0x80 : 0;									// the MSB is set until the timeout
 }
 
 
@@ -128,15 +191,18 @@ inline static uint8_t readPaddle(int pdl) {
 Sint8 audioBuffer[2][audioBufferSize] = { 0 };									// see in main() for more details
 SDL_AudioDeviceID audioDevice;
 bool muted = false;// mute/unmute switch
+bool turbo = false;																// CPU as fast as the host allows, sound off
+bool bench = false;																// headless and unthrottled, see benchStep()
+uint64_t benchDisk = 0, benchDiskAccesses = 0;									// performance counter ticks in the disk ][ switches
 
 static void playSound() {
 	static long long int lastTick = 0LL;
 	static bool SPKR = false;													// $C030 Speaker toggle
 
-	if (!muted) {
+	if (!muted && !turbo) {
 		SPKR = !SPKR;// toggle speaker state
-		Uint32 length = (int)((double)(ticks - lastTick) / 10.65625f);				// 1023000Hz / 96000Hz = 10.65625
-		lastTick = ticks;
+		Uint32 length = (int)((double)(cpu.ticks - lastTick) / 10.65625f);			// 1023000Hz / 96000Hz = 10.65625
+		lastTick = cpu.ticks;
 		if (length > audioBufferSize) length = audioBufferSize;
 		SDL_QueueAudio(audioDevice, audioBuffer[SPKR], length | 1);					// | 1 TO HEAR HIGH FREQ SOUNDS
 	}
@@ -421,22 +487,169 @@ void apple2_reset()
 	LCRD  = false;		// Language Card readable
 	LCBK2 = true;		// Language Card bank 2 enabled
 	LCWFF = false;		// Language Card pre-write flip flop
+	mapLanguageCard();
 }
 
-//========================================== MEMORY MAPPED SOFT SWITCHES HANDLER
-// this function is called from readMem and writeMem
-// it complements both functions when address is in page $C0
-uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
-	static uint8_t dLatch = 0;													// disk ][ I/O register
+//=================================================== SOFT SWITCHES DISPATCH TABLE
+// one read and one write handler per address of page $C0, filled in by
+// ioInit() and by each card for its $C0n0-$C0nF range : softSwitches() calls
+// them straight, the hot ones ($C000, $C0EC) doing nothing else
 
-	switch (address) {
-	case 0xC000: return KBD;													// KEYBOARD
-	case 0xC010: KBD &= 0x7F; return KBD;										// KBDSTROBE
+ioRead_t ioRead[256];															// $C000-$C0FF, by low byte
+ioWrite_t ioWrite[256];
+
+static uint8_t ioFloating(uint16_t address) {									// nothing there
+	return cpu.ticks % 0xFF;													// gives a 'floating' value
+}
+
+static void ioIgnore(uint16_t address, uint8_t value) {}
+
+void ioSlot(int slot, ioRead_t read, ioWrite_t write) {							// $C080 + slot * 16, 16 addresses
+	for (int address = 0x80 + (slot << 4); address < 0x90 + (slot << 4); address++) {
+		ioRead[address] = read;
+		ioWrite[address] = write;
+	}
+}
+
+
+//=================================================================== SLOT CARDS
+// plugged by slotsInit(), see reinetteslot.h
+
+slot_card_t *slots[SLOTS];														// NULL for the empty ones
+int slotC8 = 0;																	// the one whose expansion ROM is at $C800, 0 for none
+
+#define SLOT_EVENT(slot) static void slotEvent##slot(unsigned long long int due) { slots[slot]->event(slot, due); }
+SLOT_EVENT(1) SLOT_EVENT(2) SLOT_EVENT(3) SLOT_EVENT(4) SLOT_EVENT(5) SLOT_EVENT(6) SLOT_EVENT(7)
+static const schedHandler_t slotEvents[SLOTS] = { NULL, slotEvent1, slotEvent2, slotEvent3, slotEvent4, slotEvent5, slotEvent6, slotEvent7 };
+
+void slotAt(int slot, unsigned long long int due) {								// the card's event, due at that ticks value
+	schedAt(&sched, EVENT_SLOT1 + slot - 1, due, slotEvents[slot]);
+}
+
+void slotSelect(int slot) {														// its expansion ROM at $C800-$CEFF, 0 for none
+	if (!slot)																	// $CFFF, every card sees it
+		for (int other = 1; other < SLOTS; other++)
+			if (slots[other] && slots[other]->release)
+				slots[other]->release(other);
+	if (slotC8 == slot)
+		return;
+	slotC8 = slot;
+	for (int page = 0xC8; page < 0xCF; page++) {								// $CF00-$CFFF stays on the slow path
+		uint8_t *expansion = slot ? slots[slot]->expansion + ((page - 0xC8) << 8) : NULL;
+		if (readPages[page] != expansion)
+			puce6502CacheInvalidate(&cpu, page << 8, page << 8 | 0xFF);			// code seen there changed
+		readPages[page] = expansion;
+	}
+}
+
+// a $C100-$CFFF access the page tables left to softSwitches()
+static uint8_t slotAccess(uint16_t address, bool WRT) {
+	if (address == 0xCFFF)
+		slotSelect(0);															// turns off all slots expansion ROMs
+	else if (address >= 0xCF00) {
+		if (slotC8 && !WRT)
+			return slots[slotC8]->expansion[address - 0xC800];
+	}
+	else if (address < 0xC800) {
+		slot_card_t *card = slots[(address >> 8) & 7];
+		if (card && card->expansion) {											// only these pages come here
+			slotSelect((address >> 8) & 7);
+			if (card->rom && !WRT)
+				return card->rom[address & 0xFF];
+		}
+	}
+	return cpu.ticks % 0xFF;													// catch all, gives a 'floating' value
+}
+
+
+// the disk ][ controller, $C0n0-$C0nF
+
+static uint8_t dLatch = 0;														// disk ][ I/O register
+
+static uint8_t diskLatch(uint16_t address) {									// $C0EC in slot 6, read straight by the RWTS loops
+	if (disk[curDrv].writeMode)													// writting
+		disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble]=dLatch;// good luck gcc
+	else		// reading
+		dLatch=disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble];// easy peasy
+	disk[curDrv].nibble = (disk[curDrv].nibble + 1) % 0x1A00;					// turn floppy of 1 nibble
+	return dLatch;
+}
 
-	case 0xC020:// TAPEOUT (shall we listen it ? - try SAVE from applesoft)
-	case 0xC030:// SPEAKER
-	case 0xC033: playSound(); break;											// apple invader uses $C033 to output sound !
+uint8_t diskSwitches(uint16_t address, uint8_t value) {
+	switch (address & 0xF) {
+	case 0x0:
+	case 0x1:
+	case 0x2:
+	case 0x3:
+	case 0x4:
+	case 0x5:
+	case 0x6:
+	case 0x7: stepMotorQ(address); break;										// MOVE DRIVE HEAD
+	//case 0x7: stepMotor(address); break;										// MOVE DRIVE HEAD
 
+	case 0x8: disk[curDrv].motorOn = false; break;								// MOTOROFF
+	case 0x9: disk[curDrv].motorOn = true;  break;								// MOTORON
+
+	case 0xA: setDrv(0); break;													// DRIVE0EN
+	case 0xB: setDrv(1); break;													// DRIVE1EN
+
+	case 0xC: return diskLatch(address);										// Shift Data Latch
+
+	case 0xD: dLatch = value; break;											// Load Data Latch
+
+	case 0xE:// latch for READ
+		disk[curDrv].writeMode = false;
+		return disk[curDrv].readOnly ? 0x80 : 0;								// check protection
+
+	case 0xF: disk[curDrv].writeMode = true; break;								// latch for WRITE
+	}
+	return cpu.ticks % 0xFF;													// catch all, gives a 'floating' value
+}
+
+static uint8_t diskRead(uint16_t address) { return diskSwitches(address, 0); }
+static void diskWrite(uint16_t address, uint8_t value) { diskSwitches(address, value); }
+
+static uint8_t benchDiskRead(uint16_t address) {								// -bench : timed apart
+	uint64_t start = SDL_GetPerformanceCounter();
+	uint8_t value = diskSwitches(address, 0);
+	benchDisk += SDL_GetPerformanceCounter() - start;
+	benchDiskAccesses++;
+	return value;
+}
+
+static void benchDiskWrite(uint16_t address, uint8_t value) {
+	uint64_t start = SDL_GetPerformanceCounter();
+	diskSwitches(address, value);
+	benchDisk += SDL_GetPerformanceCounter() - start;
+	benchDiskAccesses++;
+}
+
+static void diskInit(int slot) {
+	if (bench)
+		ioSlot(slot, benchDiskRead, benchDiskWrite);
+	else
+		ioRead[0x8C + (slot << 4)] = diskLatch;									// the hot one
+}
+
+static void diskRelease(int slot) {												// $CFFF, as it always did
+	disk[curDrv].motorOn = false;
+}
+
+slot_card_t diskCard = { "disk ][", diskInit, NULL, diskRead, diskWrite, sl6, NULL, NULL, diskRelease };
+
+
+// the motherboard's, $C000-$C07F, and the language card in slot 0
+
+static uint8_t kbdRead(uint16_t address) { return KBD; }						// $C000 KEYBOARD
+
+static uint8_t strobeRead(uint16_t address) { KBD &= 0x7F; return KBD; }		// $C010 KBDSTROBE
+static void strobeWrite(uint16_t address, uint8_t value) { KBD &= 0x7F; }
+
+static void speakerWrite(uint16_t address, uint8_t value) { playSound(); }		// $C020 TAPEOUT, $C030 SPEAKER, $C033
+static uint8_t speakerRead(uint16_t address) { playSound(); return cpu.ticks % 0xFF; }
+
+static void videoWrite(uint16_t address, uint8_t value) {						// $C050-$C057
+	switch (address) {
 	case 0xC050: TEXT  = false; break;											// Graphics
 	case 0xC051: TEXT  = true;	break;											// Text
 	case 0xC052: MIXED = false; break;											// Mixed off
@@ -445,16 +658,27 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC055: PAGE2 = true;	break;											// PAGE2 on
 	case 0xC056: HIRES = false; break;											// HiRes off
 	case 0xC057: HIRES = true;	break;											// HiRes on
+	}
+}
+static uint8_t videoRead(uint16_t address) { videoWrite(address, 0); return cpu.ticks % 0xFF; }
 
+static uint8_t gameRead(uint16_t address) {										// $C061-$C065
+	switch (address) {
 	case 0xC061: return PB0;													// Push Button 0
 	case 0xC062: return PB1;													// Push Button 1
 	case 0xC063: return PB2;													// Push Button 2
 	case 0xC064: return readPaddle(0);											// Paddle 0
 	case 0xC065: return readPaddle(1);											// Paddle 1
+	}
+	return cpu.ticks % 0xFF;
+}
 
-	case 0xC070: resetPaddles(); break;											// paddle timer RST
+static void paddlesWrite(uint16_t address, uint8_t value) { resetPaddles(); }	// $C070 paddle timer RST
+static uint8_t paddlesRead(uint16_t address) { resetPaddles(); return cpu.ticks % 0xFF; }
 
-	case 0xC080:// LANGUAGE CARD :
+static void languageCard(uint16_t address, bool WRT) {							// $C080-$C08F
+	switch (address) {
+	case 0xC080:
 	case 0xC084: LCBK2 = 1; LCRD = 1; LCWR = 0;		 LCWFF = 0;	   break;		// LC2RD
 	case 0xC081:
 	case 0xC085: LCBK2 = 1; LCRD = 0; LCWR |= LCWFF; LCWFF = !WRT; break;		// LC2WR
@@ -470,120 +694,249 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC08E: LCBK2 = 0; LCRD = 0; LCWR = 0;		 LCWFF = 0;	   break;		// ROMONLY1
 	case 0xC08B:
 	case 0xC08F: LCBK2 = 0; LCRD = 1; LCWR |= LCWFF; LCWFF = !WRT; break;		// LC1RW
+	}
+	mapLanguageCard();
+}
+static uint8_t languageCardRead(uint16_t address) { languageCard(address, false); return cpu.ticks % 0xFF; }
+static void languageCardWrite(uint16_t address, uint8_t value) { languageCard(address, true); }
 
-	case 0xC0E0:
-	case 0xC0E1:
-	case 0xC0E2:
-	case 0xC0E3:
-	case 0xC0E4:
-	case 0xC0E5:
-	case 0xC0E6:
-	case 0xC0E7: stepMotorQ(address); break;									// MOVE DRIVE HEAD
-	//case 0xC0E7: stepMotor(address); break;									// MOVE DRIVE HEAD
-
-	case 0xCFFF:																// turn off all slots expansion ROMs - TODO : NEEDS REWORK
-	case 0xC0E8: disk[curDrv].motorOn = false; break;							// MOTOROFF
-	case 0xC0E9: disk[curDrv].motorOn = true;  break;							// MOTORON
-
-	case 0xC0EA: setDrv(0); break;												// DRIVE0EN
-	case 0xC0EB: setDrv(1); break;												// DRIVE1EN
-
-	case 0xC0EC:// Shift Data Latch
-		if (disk[curDrv].writeMode)												// writting
-			disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble]=dLatch;// good luck gcc
-		else		// reading
-			dLatch=disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble];// easy peasy
-		disk[curDrv].nibble = (disk[curDrv].nibble + 1) % 0x1A00;				// turn floppy of 1 nibble
-		return dLatch;
-
-	case 0xC0ED: dLatch = value; break;											// Load Data Latch
-
-	case 0xC0EE:// latch for READ
-		disk[curDrv].writeMode = false;
-		return disk[curDrv].readOnly ? 0x80 : 0;								// check protection
+void ioInit() {
+	for (int address = 0x00; address <= 0xFF; address++) {
+		ioRead[address] = ioFloating;
+		ioWrite[address] = ioIgnore;
+	}
+	ioRead[0x00] = kbdRead;
+	ioRead[0x10] = strobeRead;
+	ioWrite[0x10] = strobeWrite;
+	ioRead[0x20] = ioRead[0x30] = ioRead[0x33] = speakerRead;
+	ioWrite[0x20] = ioWrite[0x30] = ioWrite[0x33] = speakerWrite;
+	for (int address = 0x50; address <= 0x57; address++) {
+		ioRead[address] = videoRead;
+		ioWrite[address] = videoWrite;
+	}
+	for (int address = 0x61; address <= 0x65; address++)
+		ioRead[address] = gameRead;
+	ioRead[0x70] = paddlesRead;
+	ioWrite[0x70] = paddlesWrite;
+	ioSlot(0, languageCardRead, languageCardWrite);
+}
 
-	case 0xC0EF: disk[curDrv].writeMode = true; break;							// latch for WRITE
+void slotsInit() {																// after initPages()
+	slots[6] = &diskCard;														// the cards this machine is built with
+	for (int slot = 1; slot < SLOTS; slot++) {
+		slot_card_t *card = slots[slot];
+		if (!card)
+			continue;
+		ioSlot(slot, card->read ? card->read : ioFloating, card->write ? card->write : ioIgnore);
+		readPages[0xC0 + slot] = card->expansion ? NULL : card->rom;			// NULL : selects its expansion ROM
+		if (card->init)
+			card->init(slot);
 	}
-	return ticks % 0xFF;														// catch all, gives a 'floating' value
+}
+
+void slotsReset() {
+	slotSelect(0);
+	for (int slot = 1; slot < SLOTS; slot++)
+		if (slots[slot] && slots[slot]->reset)
+			slots[slot]->reset(slot);
+}
+
+//========================================== MEMORY MAPPED SOFT SWITCHES HANDLER
+// this function is called from readMem and writeMem
+// it complements both functions when address is in pages $C0 to $CF
+uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
+#ifdef PUCE6502_IDLE
+	if (address == 0xC000 && !WRT && !(KBD & 0x80))
+		idle.polls++;															// no key yet
+	else
+		idle.events++;															// anything else may end a wait
+#endif
+	if (address <= 0xC0FF) {
+		if (WRT) {
+			ioWrite[address & 0xFF](address, value);
+			return 0;
+		}
+		return ioRead[address & 0xFF](address);
+	}
+	return slotAccess(address, WRT);											// slots ROMs
 }
 
 
 //======================================================================= MEMORY
-// these two functions are imported into puce6502.c
+// these two functions are the 6502 bus, see cpuRead() and cpuWrite()
+// (puce6502.c inlines reinetteII+mem.h instead when built with PUCE6502_MEMMAP)
 
 uint8_t readMem(uint16_t address) {
-	if (address < RAMSIZE)
-		return ram[address];														// RAM
-
-	if (address >= ROMSTART) {
-		if (!LCRD)
-			return rom[address - ROMSTART];											// ROM
+	uint8_t *page = readPages[address >> 8];
+	if (page)
+		return page[address & 0xFF];												// RAM, ROM, LC or disk][
+	return softSwitches(address, 0, false);										// Soft Switches
+}
 
-		if (LCBK2 && (address < 0xE000))
-			return bk2[address - BK2START];											// BK2
 
-		return lgc[address - LGCSTART];												// LC
+void writeMem(uint16_t address, uint8_t value) {
+	uint8_t *page = writePages[address >> 8];
+	if (page) {
+		page[address & 0xFF] = value;												// RAM or LC
+		videoDirty[address >> 7] = 1;											// whatever it is, cheaper than checking
+		return;
 	}
+	softSwitches(address, value, true);											// Soft Switches
+}
 
-	if ((address & 0xFF00) == SL6START)
-		return sl6[address - SL6START];												// disk][
+// callbacks of the cpu context
+static uint8_t cpuRead(puce6502_t *cpu, uint16_t address) { return readMem(address); }
+static void cpuWrite(puce6502_t *cpu, uint16_t address, uint8_t value) { writeMem(address, value); }
 
-	if ((address & 0xF000) == 0xC000)
-		return softSwitches(address, 0, false);										// Soft Switches
+#ifdef PUCE6502_TRAPS
+// busy-waits of the monitor ROM, run at once while it is mapped
 
-	return ticks & 0xFF;														// catch all, gives a 'floating' value
+static void trapReturn(puce6502_t *cpu)											// the routine's RTS
+{
+	uint8_t low = readMem(0x100 + (uint8_t)(cpu->SP + 1));
+	uint8_t high = readMem(0x100 + (uint8_t)(cpu->SP + 2));
+	cpu->SP += 2;
+	cpu->PC = (high << 8 | low) + 1;
 }
 
+static unsigned int waitCycles(uint8_t a)										// WAIT, from its first instruction to its RTS
+{
+	return 7 + (5 * a * a + 27 * a) / 2;
+}
 
-void writeMem(uint16_t address, uint8_t value) {
-	if (address < RAMSIZE) {
-		ram[address] = value;														// RAM
-		return;
-	}
+static unsigned int trapWait(puce6502_t *cpu, unsigned long long int left)		// $FCA8 WAIT
+{
+	if (!cpu->A || cpu->P.D)													// 256 passes or decimal mode, left to the CPU
+		return 0;
+	if (!traps.skip && waitCycles(cpu->A) > left)								// past this run, the frame would end late
+		return 0;
+	unsigned int cycles = waitCycles(cpu->A);
+	writeMem(0x100 + cpu->SP, 0x01);											// its last PHA
+	cpu->A = 0;
+	setP(cpu, (getP(cpu) & 0x3C) | 0x03);										// N and V clear, Z and C set
+	trapReturn(cpu);
+	return cycles;
+}
 
-	if (LCWR && (address >= ROMSTART)) {
-		if (LCBK2 && (address < 0xE000)) {
-			bk2[address - BK2START] = value;										// BK2
-			return;
-		}
-		lgc[address - LGCSTART] = value;											// LC
-		return;
-	}
+static unsigned int trapBell(puce6502_t *cpu, unsigned long long int left)		// $FBDD BELL1, only when not heard
+{
+	if (!traps.skip || cpu->P.D)												// its 192 clicks, WAIT still trapped
+		return 0;
+	writeMem(0x100 + cpu->SP, 0xFB);											// its last JSR WAIT
+	writeMem(0x100 + (uint8_t)(cpu->SP - 1), 0xE8);
+	writeMem(0x100 + (uint8_t)(cpu->SP - 2), 0x01);								// and the PHA in there
+	cpu->A = readMem(0xC030);													// the last click
+	cpu->Y = 0;
+	setP(cpu, (getP(cpu) & 0x3C) | 0x03);										// N and V clear, Z and C set
+	trapReturn(cpu);
+	return 8 + waitCycles(0x40) + 2 + 192 * (17 + waitCycles(0x0C)) - 1 + 6;
+}
+#endif
 
-	if ((address & 0xF000) == 0xC000) {
-		softSwitches(address, value, true);											// Soft Switches
-		return;
-	}
+#ifdef PUCE6502_TRACE
+void traceSave()																// for puce6502trace to disassemble
+{
+	if (puce6502TraceSave(&cpu, "trace.bin"))
+		printf("last %u instructions saved to trace.bin\n", trace->count < PUCE6502_TRACE_SIZE ? (unsigned)trace->count : PUCE6502_TRACE_SIZE);
 }
 
+void traceCrash(int sig)														// the emulator itself crashed
+{
+	traceSave();
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+#endif
+
+#ifdef PUCE6502_STATS
+void statsSave()																// one CSV line per opcode
+{
+	if (puce6502StatsSave(&cpu, "stats.csv"))
+		printf("opcode counts saved to stats.csv\n");
+}
+#endif
+
 void CpuExec(unsigned long long int cycleCount)
 {
+#ifdef DASM_6502
 	unsigned int cycles_count=0;
 	unsigned int cycles=0;
 
-	while(cycles_count<cycleCount) {
-		cycles=puce6502Step();
+	while(cycles_count<cycleCount) {											// one instruction at a time to log it
+		cycles=puce6502Step(&cpu);
 		cycles_count += cycles;
-		ticks += cycles;
+		cpu.ticks += cycles;
 
-#ifdef DASM_6502
 		char disasm[256];
-		dasm(getPC(), disasm);
+		dasm(&cpu, getPC(&cpu), disasm);
 		LOG("%s\n", disasm);
+	}
+#else
+	schedRun(&sched, &cpu, cpu.ticks + cycleCount);								// stays in the CPU core up to each device event
 #endif
+#ifdef PUCE6502_TRACE
+	if (trace && trace->stopped) {												// the trigger fired
+		traceSave();
+		trace->stopped = 0;														// goes on tracing, the trigger stays fired
 	}
+#endif
 }
 
 void SysInit()
 {
+	puce6502Init();															// the CPU's tables
+	ioInit();																	// soft switches
+	cpu.readMem = cpuRead;
+	cpu.writeMem = cpuWrite;
+	schedInit(&sched);
+#ifdef PUCE6502_TRAPS
+	traps.trap[traps.count++] = (puce6502_trap_t){ 0xFCA8, trapWait };
+	traps.trap[traps.count++] = (puce6502_trap_t){ 0xFBDD, trapBell };
+	cpu.traps = &traps;
+#endif
+	initPages();																// maps them
+	slotsInit();																// and the cards
+#ifdef PUCE6502_CACHE
+	for (int page = 0x00; page <= 0xFF; page++)
+		cache.io[page] = readPages[page] == NULL;								// soft switches and empty slots
+	cpu.cache = &cache;
+#endif
+#ifdef PUCE6502_IDLE
+	cpu.idle = &idle;
+#endif
+#ifdef PUCE6502_JIT
+	cpu.readPages = readPages;													// hot code runs natively on these
+	cpu.writePages = writePages;
+#endif
+#ifdef PUCE6502_TRACE
+	trace = calloc(1, sizeof(puce6502_trace_t));
+	if (trace) {
+		char *pc = getenv("REINETTE_TRACE_PC");									// hex address saving the trace when run
+		trace->trigger = pc ? (int)strtol(pc, NULL, 16) : -1;
+		trace->after = 1000;													// and the instructions following it
+		cpu.trace = trace;
+		signal(SIGSEGV, traceCrash);
+		signal(SIGABRT, traceCrash);
+	}
+#endif
+#ifdef PUCE6502_PROFILE
+	profile = calloc(1, sizeof(puce6502_profile_t));
+	cpu.profile = profile;
+	mapLanguageCard();															// sets the banks
+#endif
+#ifdef PUCE6502_STATS
+	cpu.stats = &stats;
+#endif
 }
 
 void SysReset()
 {
 	apple2_reset();
+	slotsReset();
+	memset(videoDirty, 1, sizeof(videoDirty));									// redraws the whole screen
 
 	// reset the CPU
-	puce6502RST();	// reset the 6502
+	puce6502RST(&cpu);	// reset the 6502
 }
 
 //=======================================================================
@@ -620,6 +973,86 @@ int readBinFile(uint8_t *buf, uint32_t sz, char *fn, char* workdir, int wd_len)
 #include "dsk.h"
 #endif
 
+//================================================================== BENCHMARK
+// reinette -bench [floppy] boots the floppy, DOS 3.3.nib by default, types
+// benchScript at the first prompt and quits when the machine waits for a key
+// again, telling where the host time went. No window, no sound, the CPU runs
+// as fast as the host allows.
+
+const char *benchScript =
+	"10 HGR : HCOLOR= 3\r"
+	"20 FOR I = 0 TO 279 STEP 3 : HPLOT 140,0 TO I,159 : NEXT\r"
+	"30 FOR I = 0 TO 159 STEP 2 : HCOLOR= I / 2 - INT (I / 14) * 7 : HPLOT 0,I TO 279,159 - I : NEXT\r"
+	"RUN\r";
+const char *benchKey = NULL;													// next key to type, NULL before the first prompt
+unsigned long long int benchBoot = 0;											// cycles to the first prompt
+uint64_t benchStart, benchCpu = 0, benchVideo = 0, benchFloppy = 0;				// performance counter ticks
+
+#define BENCH_CYCLES (1023000ULL * 600)											// gives up after 10 minutes of Apple time
+
+bool benchStep()																// false once done
+{
+	if (cpu.ticks > BENCH_CYCLES)
+		return false;
+	if (cpu.PC < 0xFD1B || cpu.PC > 0xFD24 || (KBD & 0x80))						// KEYIN is not waiting for a key
+		return true;
+	if (!benchKey) {															// at the prompt
+		benchBoot = cpu.ticks;
+		benchKey = benchScript;
+	}
+	if (!*benchKey)																// back to it, the script ran
+		return false;
+	KBD = *benchKey++ | 0x80;
+	return true;
+}
+
+int benchReport()
+{
+	double frequency = SDL_GetPerformanceFrequency();
+	double wall = (SDL_GetPerformanceCounter() - benchStart) / frequency;
+	double cpuTime = (benchCpu - benchDisk) / frequency, video = benchVideo / frequency;
+	double diskTime = benchDisk / frequency;									// the floppy loaded before benchStart is apart
+
+	if (!benchKey || *benchKey) {
+		printf("bench : the script did not run in %llu cycles\n", cpu.ticks);
+		return 1;
+	}
+	printf("bench : floppy loaded in %.3f s\n", benchFloppy / frequency);
+	printf("bench : booted in %llu cycles, the script ran in %llu more\n", benchBoot, cpu.ticks - benchBoot);
+	printf("bench : %.3f s, %.1f times the speed of an Apple ][+\n", wall, cpu.ticks / 1023000.0 / wall);
+	printf("  cpu    %8.3f s\n", cpuTime);
+	printf("  video  %8.3f s\n", video);
+	printf("  disk   %8.3f s, %llu accesses to the disk ][\n", diskTime, (unsigned long long)benchDiskAccesses);
+	double other = wall - cpuTime - video - diskTime;
+	printf("  other  %8.3f s\n", other > 0 ? other : 0);
+	return 0;
+}
+
+//=================================================================== HGR DOTS
+// the color indices of the 7 dots of a HGR byte only depend on the byte, on
+// the dots on either side (bit 6 of the byte before, bit 0 of the one after)
+// and on the column's parity, one dot in two being darker : they are made once
+// per color mode and copied a byte at a time
+
+uint8_t hgrDots[2][2][2][256][7];												// [column & 1][left dot][next byte & 1][byte]
+int hgrColorMode = -1;															// the one hgrDots[] was made for
+
+void hgrInit(int color_mode)
+{
+	for (int odd = 0; odd < 2; odd++)
+		for (int left = 0; left < 2; left++)
+			for (int next = 0; next < 2; next++)
+				for (int byte = 0; byte < 256; byte++) {
+					uint16_t word = left | (byte & 0x7F) << 1 | next << 8;		// the dots, the ones on either side included
+					uint8_t colorSet = (byte & 0x80) ? 16 : 0;
+					for (int bit = 0; bit < 7; bit++) {
+						uint8_t even = (odd ^ (bit & 1)) ? 8 : 0;
+						hgrDots[odd][left][next][byte][bit] = color_mode ? color_mode*32+16+ ((byte>>bit)&1) : 32*4+((word>>bit)&7) + even + colorSet;
+					}
+				}
+	hgrColorMode = color_mode;
+}
+
 //========================================================== PROGRAM ENTRY POINT
 
 int main(int argc, char *argv[]) {
@@ -633,31 +1066,47 @@ int main(int argc, char *argv[]) {
 	SDL_Event event;
 	SDL_bool running = true, paused = false, ctrl = false, shift = false, alt = false;
 
+	char *floppy = NULL;
+	for (int arg = 1; arg < argc; arg++) {										// reinette [-turbo] [-bench] [floppy]
+		if (!strcmp(argv[arg], "-turbo"))
+			turbo = true;
+		else if (!strcmp(argv[arg], "-bench"))
+			bench = muted = true;
+		else if (!floppy)
+			floppy = argv[arg];
+	}
+	if (bench && !floppy)
+		floppy = "DOS 3.3.nib";
+
 #ifdef LOADDSK
 	fullscreen = 1;
 #endif
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+	if (!bench && SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
 		printf("failed to initialize SDL2 : %s", SDL_GetError());
 		return -1;
 	}
 
-	//SDL_Window *wdo = SDL_CreateWindow("Reinette ][+", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_RES_W * zoom, SCREEN_RES_H * zoom, SDL_WINDOW_OPENGL);
-	SDL_Window *wdo = SDL_CreateWindow("Reinette ][+", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_RES_W * zoom, SCREEN_RES_H * zoom, SDL_WINDOW_RESIZABLE);
+	SDL_Window *wdo = NULL;														// neither of them for -bench
+	SDL_Renderer *rdr = NULL;
+	if (!bench) {
+		//wdo = SDL_CreateWindow("Reinette ][+", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_RES_W * zoom, SCREEN_RES_H * zoom, SDL_WINDOW_OPENGL);
+		wdo = SDL_CreateWindow("Reinette ][+", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_RES_W * zoom, SCREEN_RES_H * zoom, SDL_WINDOW_RESIZABLE);
 #ifdef SDL_RDR_SOFTWARE
-	SDL_Renderer *rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_SOFTWARE);
-	//SDL_Renderer *rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_PRESENTVSYNC);	// SDL_RENDERER_PRESENTVSYNC 无效
+		rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_SOFTWARE);
+		//rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_PRESENTVSYNC);	// SDL_RENDERER_PRESENTVSYNC 无效
 #else
-	SDL_Renderer *rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_ACCELERATED);
-	//SDL_Renderer *rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+		rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_ACCELERATED);
+		//rdr = SDL_CreateRenderer(wdo, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 #endif
-	//SDL_SetRenderDrawBlendMode(rdr, SDL_BLENDMODE_NONE);							// SDL_BLENDMODE_BLEND);
-	SDL_EventState(SDL_DROPFILE, SDL_ENABLE);									// ask SDL2 to read dropfile events
-	//SDL_RenderSetScale(rdr, zoom, zoom);
-	SDL_Surface *sshot;															// used later for the screenshots
+		//SDL_SetRenderDrawBlendMode(rdr, SDL_BLENDMODE_NONE);						// SDL_BLENDMODE_BLEND);
+		SDL_EventState(SDL_DROPFILE, SDL_ENABLE);								// ask SDL2 to read dropfile events
+		//SDL_RenderSetScale(rdr, zoom, zoom);
 
-	SDL_SetWindowMinimumSize(wdo, SCREEN_RES_W, SCREEN_RES_H);
+		SDL_SetWindowMinimumSize(wdo, SCREEN_RES_W, SCREEN_RES_H);
 
-	if(fullscreen) SDL_SetWindowFullscreen(wdo, SDL_WINDOW_FULLSCREEN_DESKTOP);
+		if(fullscreen) SDL_SetWindowFullscreen(wdo, SDL_WINDOW_FULLSCREEN_DESKTOP);
+	}
+	SDL_Surface *sshot;															// used later for the screenshots
 
 	unsigned char screenData[SCREEN_RES_W*SCREEN_RES_H];
 	SDL_Color colors[128+32];
@@ -809,8 +1258,10 @@ int main(int argc, char *argv[]) {
 	//=================================================== SDL AUDIO INITIALIZATION
 
 	SDL_AudioSpec desired = { 96000, AUDIO_S8, 1, 0, 4096, 0, 0, NULL, NULL };
-	audioDevice = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, SDL_FALSE);		// get the audio device ID
-	SDL_PauseAudioDevice(audioDevice, muted);									// unmute it (muted is false)
+	if (!bench) {
+		audioDevice = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, SDL_FALSE);	// get the audio device ID
+		SDL_PauseAudioDevice(audioDevice, muted);								// unmute it (muted is false)
+	}
 	uint8_t volume = 4;
 
 	for (int i = 0; i < audioBufferSize; i++) {									// two audio buffers,
@@ -827,6 +1278,7 @@ int main(int argc, char *argv[]) {
 
 	enum characterAttribute { A_NORMAL, A_INVERSE, A_FLASH } glyphAttr;			// character attribute in TEXT
 	uint8_t flashCycle = 0;														// TEXT cursor flashes at 2Hz
+	int shownMode = -1, shownDrive = -1;										// of the last frame, see videoDirty
 
 	SDL_Rect drvRect[2] = { { 272, 188, 4, 4 }, { 276, 188, 4, 4 } };			// disk drive status squares
 
@@ -891,8 +1343,13 @@ int main(int argc, char *argv[]) {
 
 	//========================================================== VM INITIALIZATION
 
-	if (argc > 1)
-		insertFloppy(wdo, argv[1], 0);									// load floppy if provided at command line
+	benchFloppy = SDL_GetPerformanceCounter();
+	if (floppy) {
+		if (!insertFloppy(wdo, floppy, 0) && bench) {							// load floppy if provided at command line
+			printf("bench : can't load %s\n", floppy);
+			return 1;
+		}
+	}
 #ifdef LOADDSK
 	else {
 
@@ -920,6 +1377,7 @@ int main(int argc, char *argv[]) {
 	}
 */
 #endif
+	benchFloppy = SDL_GetPerformanceCounter() - benchFloppy;
 
 	SysReset();
 
@@ -932,22 +1390,36 @@ int main(int argc, char *argv[]) {
 	uint64_t last_ticks = SDL_GetTicks64();
 	uint64_t current_ticks;
 
+	benchStart = SDL_GetPerformanceCounter();
 	while (running) {
 
+		uint64_t start = SDL_GetPerformanceCounter();
 		if (!paused) {// the apple II is clocked at 1023000.0 Hhz
-			//puce6502Exec(17050);														// execute instructions for 1/60 of a second
+			//puce6502Exec(&cpu, 17050);												// execute instructions for 1/60 of a second
 			//while (disk[curDrv].motorOn && ++tries)									// until motor is off or i reaches 255+1=0
-			//	puce6502Exec(5000);														// speed up drive access artificially
+			//	puce6502Exec(&cpu, 5000);												// speed up drive access artificially
 
-			CpuExec(17050);														// execute instructions for 1/60 of a second
-			while (disk[curDrv].motorOn && ++tries)									// until motor is off or i reaches 255+1=0
-				CpuExec(5000);													// speed up drive access artificially
+			uint64_t turbo_end = SDL_GetTicks64() + 50/3;							// turbo : as many as fit in 1/60 of a second
+			do {
+#ifdef PUCE6502_IDLE
+				idle.idle = 0;
+#endif
+#ifdef PUCE6502_TRAPS
+				traps.skip = turbo || bench;									// no time to wait for
+#endif
+				CpuExec(17050);													// execute instructions for 1/60 of a second
+				while (disk[curDrv].motorOn && ++tries)								// until motor is off or i reaches 255+1=0
+					CpuExec(5000);												// speed up drive access artificially
+			} while (turbo && SDL_GetTicks64() < turbo_end);
 		}
+		benchCpu += SDL_GetPerformanceCounter() - start;
 
+		if (bench && !benchStep())
+			running = false;
 
 		//=============================================================== USER INPUT
 
-		while(1) {
+		while (!bench) {
 
 		while (SDL_PollEvent(&event)) {
 			alt	  = SDL_GetModState() & KMOD_ALT   ? true : false;
@@ -979,6 +1451,7 @@ int main(int argc, char *argv[]) {
 					ram[0x3F4] = 0;														// unset the Power-UP byte
 					SysReset();														// do a cold reset
 					memset(ram, 0, sizeof(ram));
+					puce6502CacheInvalidate(&cpu, 0x0000, 0xBFFF);					// RAM changed behind the 6502
 				}
 			}
 
@@ -1013,6 +1486,7 @@ int main(int argc, char *argv[]) {
 						"alt F9\twrites the changes of the floppy in drive 1\n"
 						"\n"
 						"F11\tpause / un-pause the emulator\n"
+						"shift F11\tturbo on / off, sound off\n"
 						"\n"
 						"ctrl F12\treset\n"
 						"\n"
@@ -1047,7 +1521,7 @@ int main(int argc, char *argv[]) {
 						while (clipboardText[c]) {											// all chars until ascii NUL
 							KBD = clipboardText[c++] | 0x80;								// set bit7
 							if (KBD == 0x8A) KBD = 0x8D;									// translate Line Feed to Carriage Ret
-							puce6502Exec(400000);											// give cpu (and applesoft) some cycles to process each char
+							puce6502Exec(&cpu, 400000);										// give cpu (and applesoft) some cycles to process each char
 						}
 						SDL_free(clipboardText);											// release the ressource
 					}
@@ -1112,9 +1586,20 @@ int main(int argc, char *argv[]) {
 					{ticks_step=1;last_ticks=SDL_GetTicks64();}
 				break;
 
-				case SDLK_F10: debug = debug?0:1;break;
+				case SDLK_F10:
+#ifdef PUCE6502_TRACE
+					if (ctrl) { traceSave(); break; }									// CTRL-F10 saves the last instructions
+#endif
+#ifdef PUCE6502_STATS
+					if (shift) { statsSave(); break; }									// SHIFT-F10 saves the opcode counts
+#endif
+					debug = debug?0:1;break;
 
-				case SDLK_F11: paused = !paused; if(!paused){ticks_step=1;last_ticks=SDL_GetTicks64();} break;									// toggle pause
+				case SDLK_F11:
+					if (shift) turbo = !turbo;											// toggle turbo
+					else paused = !paused;												// toggle pause
+					if(!paused){ticks_step=1;last_ticks=SDL_GetTicks64();}
+					break;
 
 				case SDLK_F12: if (ctrl) SysReset(); break;						// simulate a reset
 
@@ -1206,53 +1691,57 @@ int main(int argc, char *argv[]) {
 		}
 
 		current_ticks = SDL_GetTicks64();
+		if (turbo) {															// the CPU set the pace, one frame shown
+			ticks_step = 1;
+			last_ticks = current_ticks;
+			break;
+		}
 		if( current_ticks-last_ticks > ticks_step*50/3 ) {		// ticks_step*1000/60 == ticks_step*50/3
 			ticks_step++;
 			//if(current_ticks-last_ticks>=1000 && ticks_step>=60) {last_ticks+=1000;ticks_step-=60;}
 			break;
 		}
+#ifdef PUCE6502_IDLE
+		if (idle.idle)															// the CPU waits for a key, so does the host
+			SDL_WaitEventTimeout(NULL, last_ticks + ticks_step*50/3 + 1 - current_ticks);
+#endif
 
 		}	// while
 
 		//============================================================= VIDEO OUTPUT
+		// only the lines whose bytes were written since the last frame are
+		// redrawn, all of them when the mode changed, and the text when it flashes
+
+		start = SDL_GetPerformanceCounter();
+
+		int mode = TEXT | MIXED << 1 | PAGE2 << 2 | HIRES << 3 | color_mode << 4;
+		bool redrawAll = mode != shownMode;
+#ifdef PUCE6502_JIT
+		redrawAll = true;														// native code writes past writeMem()
+#endif
+		bool flashing = flashCycle == 0 || flashCycle == 15;					// the FLASH characters turn over
+		bool redrawn = redrawAll;
+		shownMode = mode;
 
 		// HIGH RES GRAPHICS
 		if (!TEXT && HIRES) {
-			uint16_t word;
-			uint8_t bit, colorSet, even;
 			uint16_t vRamBase = 0x2000 + PAGE2 * 0x2000;
 			uint8_t lastLine = MIXED ? 160 : 192;
-			uint16_t byte_1, byte_2;
-			//uint8_t bits[16], pbit;
-			//uint8_t colorIdx = 0;														// to index the color arrays
+			if (hgrColorMode != color_mode)										// F8 was pressed
+				hgrInit(color_mode);
 
 			for (int line = 0; line < lastLine; line++) {							// for every line
-				int off = line*280;
-
-				word = 0;
-				byte_1 = ram[vRamBase + offsetHGR[line] + 0+0];
-				byte_2 = 0;
-				even = 0;
-				for (int col = 0; col < 40; col ++) {								// for every 7 horizontal dots
-					if(col==39)
-						byte_2 = 0;
-					else
-						byte_2 = ram[vRamBase + offsetHGR[line] + col+1];
-
-					colorSet = (byte_1&0x80)?16:0;
-					word = word | ((byte_1&0x007f)<<1) | ((byte_2&0x0001)<<8);
-
-					for (bit=0; bit<7; bit++) {
-						if(color_mode)
-							screenData[off] = color_mode*32+16+ ((byte_1>>bit)&1);
-						else
-							screenData[off] = 32*4+((word>>bit)&7) + even + colorSet;
-						even = even?0:8;
-						off++;
-					}
-
-					word = (byte_1>>6)&1;
-					byte_1=byte_2;
+				if (!redrawAll && !videoDirty[(vRamBase + offsetHGR[line]) >> 7])
+					continue;
+				redrawn = true;
+				uint8_t *dots = screenData + line*280;
+				uint8_t *bytes = ram + vRamBase + offsetHGR[line];
+				uint8_t left = 0;												// bit 6 of the byte before
+				for (int col = 0; col < 40; col++) {							// for every 7 horizontal dots
+					uint8_t next = col < 39 ? bytes[col + 1] & 1 : 0;
+					memcpy(dots, hgrDots[col & 1][left][next][bytes[col]], 7);
+					dots += 7;
+					left = (bytes[col] >> 6) & 1;
 				}
 
 /*
@@ -1308,6 +1797,9 @@ int main(int argc, char *argv[]) {
 			for (int col = 0; col < 40; col++) {									// for each column
 				//pixelGR.x = col * 7;
 				for (int line = 0; line < lastLine; line++) {							// for each row
+					if (!redrawAll && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					//pixelGR.y = line * 8;													// first block
 
 					glyph = ram[vRamBase + offsetGR[line] + col];						// read video memory
@@ -1345,6 +1837,9 @@ int main(int argc, char *argv[]) {
 
 			for (int col = 0; col < 40; col++) {									// for each column
 				for (int line = firstLine; line < 24; line++) {							// for each row
+					if (!redrawAll && !flashing && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					glyph = ram[vRamBase + offsetGR[line] + col];						// read video memory
 					if (glyph > 0x7F) glyphAttr = A_NORMAL;								// is NORMAL ?
 					else if (glyph < 0x40) glyphAttr = A_INVERSE;						// is INVERSE ?
@@ -1392,11 +1887,19 @@ int main(int argc, char *argv[]) {
 
 		if (++flashCycle == 30)														// increase cursor flash cycle
 			flashCycle = 0;															// reset to zero every half second
-
-		Uint32 fmt = sdlSurface->format->format;
-		SDL_Surface *surf = SDL_ConvertSurfaceFormat(sdlScreen, fmt, 0);
-		SDL_BlitScaled(surf,NULL,sdlSurface,NULL);
-		SDL_FreeSurface(surf);
+		memset(videoDirty, 0, sizeof(videoDirty));
+
+		int drive = disk[curDrv].motorOn ? 1 + curDrv * 2 + disk[curDrv].writeMode : 0;
+		if (drive != shownDrive)												// its square is drawn over the screen
+			redrawn = true;
+		shownDrive = drive;
+
+		if (redrawn) {															// else the same as the last frame
+			Uint32 fmt = sdlSurface->format->format;
+			SDL_Surface *surf = SDL_ConvertSurfaceFormat(sdlScreen, fmt, 0);
+			SDL_BlitScaled(surf,NULL,sdlSurface,NULL);
+			SDL_FreeSurface(surf);
+		}
 
 		//====================================================== DISPLAY DISK STATUS
 		// red for writes
@@ -1405,6 +1908,10 @@ int main(int argc, char *argv[]) {
 			SDL_FillRect(sdlSurface, &drvRect[curDrv],
 				(disk[curDrv].writeMode)?SDL_MapRGBA(sdlSurface->format, 255, 0, 0,85):SDL_MapRGBA(sdlSurface->format, 0, 255, 0,85) );
 
+		benchVideo += SDL_GetPerformanceCounter() - start;
+		if (bench)																// composed, not shown
+			continue;
+
 		SDL_Texture *sdlTex;
 		sdlTex = SDL_CreateTextureFromSurface(rdr, sdlSurface);
 		SDL_RenderCopy(rdr, sdlTex, 0, 0);
@@ -1421,5 +1928,14 @@ int main(int argc, char *argv[]) {
 
 	SDL_AudioQuit();
 	SDL_Quit();
+#ifdef PUCE6502_PROFILE
+	if (puce6502ProfileReport(&cpu, "profile.txt", 50) && puce6502ProfileStacks(&cpu, "profile.folded"))
+		printf("profile saved to profile.txt and profile.folded\n");		// the latter for flame graphs
+#endif
+#ifdef PUCE6502_STATS
+	statsSave();
+#endif
+	if (bench)
+		return benchReport();
 	return 0;
 }
@@ -0,0 +1,43 @@
+/*
+  reinette II plus memory map, for puce6502.c
+
+  Build puce6502.c with -DPUCE6502_MEMMAP='"reinetteII+mem.h"' and the core
+  reads and writes RAM, ROM and language card pages straight through the page
+  tables of reinetteII+.c, inlined into every opcode. Only the I/O pages
+  ($C000-$CFFF, NULL entries) still call out to softSwitches().
+
+  Without the define, the core uses the extern readMem() and writeMem().
+*/
+
+#ifndef _REINETTEIIPLUS_MEM_H
+#define _REINETTEIIPLUS_MEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "puce6502.h"
+
+extern uint8_t *readPages[256];  // defined in reinetteII+.c
+extern uint8_t *writePages[256];
+extern uint8_t videoDirty[0x10000 >> 7];  // for the renderer
+
+uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT);
+
+static inline uint8_t memRead(puce6502_t *cpu, uint16_t address) {
+	const uint8_t *page = readPages[address >> 8];
+	if (page)
+		return page[address & 0xFF];
+	return softSwitches(address, 0, false);
+}
+
+static inline void memWrite(puce6502_t *cpu, uint16_t address, uint8_t value) {
+	uint8_t *page = writePages[address >> 8];
+	if (page) {
+		page[address & 0xFF] = value;
+		videoDirty[address >> 7] = 1;
+	}
+	else
+		softSwitches(address, value, true);
+}
+
+#endif
@@ -31,6 +31,15 @@
 #include <SDL2/SDL.h>
 
 #include "puce6502.h"
+#include "puce6502sched.h"
+#include "reinetteslot.h"
+#ifdef PUCE6502_TRACE
+#include <signal.h>
+#include <stdlib.h>
+#endif
+#ifdef PUCE6502_PROFILE
+#include <stdlib.h>
+#endif
 #include "dsk2nib.h"
 #include "nib2dsk.h"
 
@@ -59,6 +68,28 @@ int debug=0;
 
 // Apple IIe and IIee
 
+// the 6502, its memory callbacks are set by SysInit()
+puce6502_t cpu;
+sched_t sched;																	// device events, see puce6502sched.h
+#ifdef PUCE6502_CACHE
+puce6502_cache_t cache;	// predecoded 6502 code, see puce6502cache.h
+#endif
+#ifdef PUCE6502_IDLE
+puce6502_idle_t idle;															// loops waiting for a key, see puce6502.c
+#endif
+#ifdef PUCE6502_TRACE
+puce6502_trace_t *trace;														// last instructions run, see puce6502trace.c
+#endif
+#ifdef PUCE6502_PROFILE
+puce6502_profile_t *profile;													// cycles spent per address and per subroutine
+#endif
+#ifdef PUCE6502_TRAPS
+puce6502_traps_t traps;															// monitor routines done at once, see trapWait()
+#endif
+#ifdef PUCE6502_STATS
+puce6502_stats_t stats;															// runs of each opcode, see puce6502StatsSave()
+#endif
+
 // memory layout
 
 #define LGCSTART 0xD000
@@ -197,7 +228,27 @@ bool STORE80;
 bool INTCXROM;
 bool SLOTC3ROM;
 bool IOUDIS;
-bool VERTBLANK;
+bool VERTBLANK;				// during the vertical blanking, see vblStart()
+
+//========================================================================= VBL
+
+enum { EVENT_VBL, EVENT_SLOT1 };												// device events, see sched : then one per slot, see slotAt()
+
+#define VBL_SHOWN (192 * 65)													// cycles of the 192 lines shown
+#define VBL_BLANK (70 * 65)														// and of the 70 blanked ones
+
+static void vblEnd(unsigned long long int due);
+
+static void vblStart(unsigned long long int due) {								// scheduled once a frame
+	VERTBLANK = true;
+	schedAt(&sched, EVENT_VBL, due + VBL_BLANK, vblEnd);
+}
+
+static void vblEnd(unsigned long long int due) {
+	VERTBLANK = false;
+	schedAt(&sched, EVENT_VBL, due + VBL_SHOWN, vblStart);
+}
+
 
 //====================================================================== PADDLES
 
@@ -205,26 +256,20 @@ uint8_t PB0 = 0;// $C061 Push Button 0 (bit 7) / Open Apple
 uint8_t PB1 = 0;// $C062 Push Button 1 (bit 7) / Solid Apple
 uint8_t PB2 = 0;// $C063 Push Button 2 (bit 7) / shift mod !!!
 float GCP[2] = { 127.0f, 127.0f };												// GC Position ranging from 0 (left) to 255 right
-float GCC[2] = { 0.0f };														// $C064 (GC0) and $C065 (GC1) Countdowns
+unsigned long long int GCEnd[2];												// $C064 (GC0) and $C065 (GC1) Countdowns end, in ticks
 int GCD[2] = { 0 };// GC0 and GC1 Directions (left/down or right/up)
 int GCA[2] = { 0 };// GC0 and GC1 Action (push or release)
 uint8_t GCActionSpeed = 8;														// Game Controller speed at which it goes to the edges
 uint8_t GCReleaseSpeed = 8;														// Game Controller speed at which it returns to center
-long long int GCCrigger;														// $C070 the tick at which the GCs were reseted
+#define GCCycles 11																// per position unit, a turn of the monitor's PREAD loop
 
-inline static void resetPaddles() {
-	GCC[0] = GCP[0] * GCP[0];													// initialize the countdown for both paddles
-	GCC[1] = GCP[1] * GCP[1];													// to the square of their actuall values (positions)
-	GCCrigger = ticks;															// records the time this was done
+inline static void resetPaddles() {											// $C070 starts both countdowns
+	GCEnd[0] = cpu.ticks + (unsigned long long int)GCP[0] * GCCycles;			// which last as long as the paddle
+	GCEnd[1] = cpu.ticks + (unsigned long long int)GCP[1] * GCCycles;			// positions
 }
 
 inline static uint8_t readPaddle(int pdl) {
-	const float GCFreq = 6.6;													// the speed at which the GC values decrease
-
-	GCC[pdl] -= (ticks - GCCrigger) / GCFreq;									// decreases the countdown
-	if (GCC[pdl] <= 0)															// timeout
-		return GCC[pdl] = 0;														// returns 0
-	return 0x80;	// not timeout, return something with the MSB set
+	return cpu.ticks < GCEnd[pdl] ? 0x80 : 0;									// the MSB is set until the timeout
 }
 
 
@@ -234,15 +279,16 @@ inline static uint8_t readPaddle(int pdl) {
 Sint8 audioBuffer[2][audioBufferSize] = { 0 };									// see in main() for more details
 SDL_AudioDeviceID audioDevice;
 bool muted = false;// mute/unmute switch
+bool turbo = false;																// CPU as fast as the host allows, sound off
 
 static void playSound() {
 	static long long int lastTick = 0LL;
 	static bool SPKR = false;													// $C030 Speaker toggle
 
-	if (!muted) {
+	if (!muted && !turbo) {
 		SPKR = !SPKR;// toggle speaker state
-		Uint32 length = (int)((double)(ticks - lastTick) / 10.65625f);			// 1023000Hz / 96000Hz = 10.65625
-		lastTick = ticks;
+		Uint32 length = (int)((double)(cpu.ticks - lastTick) / 10.65625f);		// 1023000Hz / 96000Hz = 10.65625
+		lastTick = cpu.ticks;
 		if (length > audioBufferSize) length = audioBufferSize;
 		SDL_QueueAudio(audioDevice, audioBuffer[SPKR], length | 1);				// | 1 TO HEAR HIGH FREQ SOUNDS
 	}
@@ -546,8 +592,7 @@ void Mmu_init() {
 	INTCXROM = false;															// use slots roms
 	SLOTC3ROM = false;															// use AUX Slot rom
 
-	IOUDIS = false;
-	VERTBLANK = true;
+	IOUDIS = false;																// VERTBLANK runs on, see vblStart()
 
 	//memset(ram,	 0xFF, sizeof(ram));										// 48K of MAIN in $0000-$BFFF
 	//memset(aux,	 0xFF, sizeof(aux));										// 48K of AUX memory
@@ -576,33 +621,235 @@ void apple2_reset()
 */
 }
 
-//========================================== MEMORY MAPPED SOFT SWITCHES HANDLER
-// this function is called from readMem and writeMem
-// it complements both functions when address is in page $C0
-uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
-  static uint8_t dLatch = 0;													// disk ][ I/O register
-
-  switch (address) {
-	// MEMORY MANAGEMENT (and KEYBOARD)
-	case 0xC000: if (WRT) STORE80	 = false; else return KBD; break;			// cause PAGE2 on to select AUX -- KEYBOARD return key code - if hi-bit is set the key code (7 lo-bits) is valid
-	case 0xC001: if (WRT) STORE80	 = true;  break;							// allow PAGE2 to switch MAIN / AUX
-	case 0xC002: if (WRT) RAMRD		 = false; break;							// read from MAIN
-	case 0xC003: if (WRT) RAMRD		 = true;  break;							// read from AUX
-	case 0xC004: if (WRT) RAMWRT	 = false; break;							// write to MAIN
-	case 0xC005: if (WRT) RAMWRT	 = true;  break;							// write to AUX
-	case 0xC006: if (WRT) INTCXROM	 = false; break;							// set peripheral roms for peripherals ($C100-$CFFF)
-	case 0xC007: if (WRT) INTCXROM	 = true;  break;							// set internal rom for peripherals ($C100-$CFFF)
-	case 0xC008: if (WRT) ALTZP		 = false; break;							// MAIN stack & rero page
-	case 0xC009: if (WRT) ALTZP		 = true;  break;							// AUX stack & rero page
-	case 0xC00A: if (WRT) SLOTC3ROM	 = false; break;							// ROM in Slot 3
-	case 0xC00B: if (WRT) SLOTC3ROM	 = true;  break;							// ROM in AUX Slot
-	case 0xC00C: if (WRT) COL80		 = false; break;							// 80 COL OFF -> 40 COL
-	case 0xC00D: if (WRT) COL80		 = true;  break;							// 80 COL ON
-	case 0xC00E: if (WRT) ALTCHARSET = false; break;							// primary character set
-	case 0xC00F: if (WRT) ALTCHARSET = true;  break;							// alternate character set
-	case 0xC010: KBD &= 0x7F;  return KBD;										// KBDSTROBE, clear hi-bit and return key code
-
-	// SOFT SWITCH STATUS FLAGS
+//================================================================== PAGE TABLES
+// one entry per 256 bytes page, pointing straight into ram, aux, rom, their
+// language cards or a slot ROM, rebuilt by mmuRemap() when a soft switch
+// changes the mapping. A NULL entry marks an I/O page : $C0 for the soft
+// switches, $CF for the one at $CFFF and the $Cn00 page of a card with an
+// expansion ROM, all left to readMem() and writeMem()
+
+uint8_t *readPages[256];														// where CPU reads of each page go
+uint8_t *writePages[256];														// where CPU writes of each page go
+uint8_t romSink[256];															// swallows writes to ROM
+uint8_t videoDirty[0x10000 >> 7];												// 128 bytes blocks written since the last frame, MAIN or AUX
+uint8_t *slotRoms[SLOTS] = { NULL, sl1, sl2, sl3, sl4, sl5, sl6, sl7 };			// $Cn00 of each slot, see slotsInit()
+uint8_t *slotExpansion = slrom[0];												// $C800-$CFFE, see slotSelect()
+int slotC8 = 0;																	// the card whose expansion ROM it is, 0 for none
+
+static void mapPage(int page, uint8_t *read, uint8_t *write) {
+	if (readPages[page] != read)
+		puce6502CacheInvalidate(&cpu, page << 8, page << 8 | 0xFF);				// code seen there changed
+	readPages[page] = read;
+	writePages[page] = write;
+}
+
+#ifdef PUCE6502_PROFILE
+void profileRemap() {															// bank of each page : LC + 3 * AUX
+	if (!profile) return;
+	for (int page = 0x00; page <= 0xFF; page++) {
+		bool auxPage = page < 0x02 ? ALTZP : RAMRD;
+		if (STORE80 && page >= 0x04 && page <= 0x07) auxPage = PAGE2;
+		if (STORE80 && page >= 0x20 && page <= 0x3F) auxPage = PAGE2 && HIRES;
+		if (page >= 0xC0) auxPage = page >= 0xD0 && LCRD && ALTZP;				// ROM is never banked
+		uint8_t lc = page >= 0xD0 && LCRD ? (LCBK2 && page < 0xE0) ? 2 : 1 : 0;
+		profile->bank[page] = lc + 3 * auxPage;
+	}
+}
+#endif
+
+#ifdef PUCE6502_TRAPS
+void trapsRemap() {																// the monitor ROM's
+	for (int i = 0; i < traps.count; i++)
+		traps.mapped[traps.trap[i].address >> 8] = !LCRD;						// not when the LC replaces it
+}
+#endif
+
+int mmuSwitches() {																// what mmuRemap() reads of them, to skip it when unchanged
+	bool page2 = STORE80 && PAGE2;												// PAGE2 and HIRES only bank with 80STORE
+	return STORE80 | page2 << 1 | (page2 && HIRES) << 2 | RAMRD << 3 | RAMWRT << 4 | ALTZP << 5
+		| INTCXROM << 6 | SLOTC3ROM << 7 | LCRD << 8 | LCWR << 9 | LCBK2 << 10;
+}
+
+void mmuRemap() {																// all pages, from the switches
+	for (int page = 0x00; page < 0xC0; page++) {								// MAIN or AUX
+		bool auxRead = page < 0x02 ? ALTZP : RAMRD;
+		bool auxWrite = page < 0x02 ? ALTZP : RAMWRT;
+		if (STORE80 && page >= 0x04 && page <= 0x07)							// TEXT PAGE 1
+			auxRead = auxWrite = PAGE2;
+		if (STORE80 && page >= 0x20 && page <= 0x3F)							// HIRES PAGE 1
+			auxRead = auxWrite = PAGE2 && HIRES;
+		mapPage(page, (auxRead ? aux : ram) + (page << 8), (auxWrite ? aux : ram) + (page << 8));
+	}
+	mapPage(0xC0, NULL, NULL);													// SOFT SWITCHES
+	for (int page = 0xC1; page < 0xCF; page++) {								// SLOTS ROMS or ROM
+		bool internal = INTCXROM || (page == 0xC3 && !SLOTC3ROM) || (page >= 0xC8 && !SLOTC3ROM && !slotC8);	// video firmware
+		uint8_t *slot = page < 0xC8 ? slotRoms[page & 7] : slotExpansion + (page << 8) - SLROMSTART;
+		if (internal)
+			slot = rom + (page << 8) - ROMSTART;
+		mapPage(page, slot, slot ? romSink : NULL);								// NULL : selects the card's expansion ROM
+	}
+	mapPage(0xCF, NULL, NULL);													// $CFFF
+	for (int page = 0xD0; page <= 0xFF; page++) {								// ROM, MAIN-BK1, MAIN-BK2, AUX-BK1 or AUX-BK2
+		uint8_t *lc = (ALTZP ? auxlgc : ramlgc) + (page << 8) - LGCSTART;		// of AUX or MAIN
+		if (LCBK2 && page < 0xE0)
+			lc = (ALTZP ? auxbk2 : rambk2) + (page << 8) - BK2START;			// bank 2
+		mapPage(page, LCRD ? lc : rom + (page << 8) - ROMSTART, LCWR ? lc : romSink);
+	}
+#ifdef PUCE6502_PROFILE
+	profileRemap();
+#endif
+#ifdef PUCE6502_TRAPS
+	trapsRemap();
+#endif
+}
+
+
+//=================================================== SOFT SWITCHES DISPATCH TABLE
+// one read and one write handler per address of page $C0, filled in by
+// ioInit() and by each card for its $C0n0-$C0nF range : softSwitches() calls
+// them straight, the hot ones ($C000, $C0EC) doing nothing else
+
+ioRead_t ioRead[256];															// $C000-$C0FF, by low byte
+ioWrite_t ioWrite[256];
+
+static uint8_t ioFloating(uint16_t address) {									// nothing there
+	return cpu.ticks % 0xFF;													// gives a 'floating' value
+}
+
+static void ioIgnore(uint16_t address, uint8_t value) {}
+
+void ioSlot(int slot, ioRead_t read, ioWrite_t write) {							// $C080 + slot * 16, 16 addresses
+	for (int address = 0x80 + (slot << 4); address < 0x90 + (slot << 4); address++) {
+		ioRead[address] = read;
+		ioWrite[address] = write;
+	}
+}
+
+
+//=================================================================== SLOT CARDS
+// plugged by slotsInit(), see reinetteslot.h
+
+slot_card_t *slots[SLOTS];														// NULL for the empty ones
+
+#define SLOT_EVENT(slot) static void slotEvent##slot(unsigned long long int due) { slots[slot]->event(slot, due); }
+SLOT_EVENT(1) SLOT_EVENT(2) SLOT_EVENT(3) SLOT_EVENT(4) SLOT_EVENT(5) SLOT_EVENT(6) SLOT_EVENT(7)
+static const schedHandler_t slotEvents[SLOTS] = { NULL, slotEvent1, slotEvent2, slotEvent3, slotEvent4, slotEvent5, slotEvent6, slotEvent7 };
+
+void slotAt(int slot, unsigned long long int due) {								// the card's event, due at that ticks value
+	schedAt(&sched, EVENT_SLOT1 + slot - 1, due, slotEvents[slot]);
+}
+
+void slotSelect(int slot) {														// its expansion ROM at $C800-$CFFE, 0 for none
+	if (!slot)																	// $CFFF, every card sees it
+		for (int other = 1; other < SLOTS; other++)
+			if (slots[other] && slots[other]->release)
+				slots[other]->release(other);
+	if (slotC8 == slot)
+		return;
+	slotC8 = slot;
+	slotExpansion = slot ? slots[slot]->expansion : slrom[0];
+	mmuRemap();
+}
+
+// an access to the $Cn00 page of a card with an expansion ROM
+static uint8_t slotAccess(uint16_t address) {
+	slot_card_t *card = slots[(address >> 8) & 7];
+	slotSelect((address >> 8) & 7);
+	return card->rom ? card->rom[address & 0xFF] : cpu.ticks % 0xFF;
+}
+
+
+// the disk ][ controller, $C0n0-$C0nF
+
+static uint8_t dLatch = 0;														// disk ][ I/O register
+
+static uint8_t diskLatch(uint16_t address) {									// $C0EC in slot 6, read straight by the RWTS loops
+	if (disk[curDrv].writeMode)													// writting
+		disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble]=dLatch;// good luck gcc
+	else																		// reading
+		dLatch=disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble];// easy peasy
+	disk[curDrv].nibble = (disk[curDrv].nibble + 1) % 0x1A00;					// turn floppy of 1 nibble
+	return dLatch;
+}
+
+uint8_t diskSwitches(uint16_t address, uint8_t value) {
+	switch (address & 0xF) {
+	case 0x0:
+	case 0x1:
+	case 0x2:
+	case 0x3:
+	case 0x4:
+	case 0x5:
+	case 0x6:
+	case 0x7: stepMotorQ(address); break;										// MOVE DRIVE HEAD
+	//case 0x7: stepMotor(address); break;										// MOVE DRIVE HEAD
+
+	case 0x8: disk[curDrv].motorOn = false; break;								// MOTOROFF
+	case 0x9: disk[curDrv].motorOn = true;  break;								// MOTORON
+
+	case 0xA: setDrv(0); break;													// DRIVE0EN
+	case 0xB: setDrv(1); break;													// DRIVE1EN
+
+	case 0xC: return diskLatch(address);										// Shift Data Latch
+
+	case 0xD: dLatch = value; break;											// Load Data Latch
+
+	case 0xE:																	// latch for READ
+		disk[curDrv].writeMode = false;
+		return disk[curDrv].readOnly ? 0x80 : 0;								// check protection
+
+	case 0xF: disk[curDrv].writeMode = true; break;								// latch for WRITE
+	}
+	return cpu.ticks % 0xFF;													// catch all, gives a 'floating' value
+}
+
+static uint8_t diskRead(uint16_t address) { return diskSwitches(address, 0); }
+static void diskWrite(uint16_t address, uint8_t value) { diskSwitches(address, value); }
+
+static void diskInit(int slot) {
+	ioRead[0x8C + (slot << 4)] = diskLatch;										// the hot one
+}
+
+static void diskRelease(int slot) {												// $CFFF, as it always did
+	disk[curDrv].motorOn = false;
+}
+
+slot_card_t diskCard = { "disk ][", diskInit, NULL, diskRead, diskWrite, sl6, NULL, NULL, diskRelease };
+
+
+// the motherboard's, $C000-$C07F, and the language card used with MAIN and AUX
+
+static uint8_t kbdRead(uint16_t address) { return KBD; }						// $C000 KEYBOARD
+
+static void memoryWrite(uint16_t address, uint8_t value) {						// $C000-$C00F MEMORY MANAGEMENT
+	int switches = mmuSwitches();
+	switch (address) {
+	case 0xC000: STORE80	= false; break;										// cause PAGE2 on to select AUX
+	case 0xC001: STORE80	= true;  break;										// allow PAGE2 to switch MAIN / AUX
+	case 0xC002: RAMRD		= false; break;										// read from MAIN
+	case 0xC003: RAMRD		= true;  break;										// read from AUX
+	case 0xC004: RAMWRT		= false; break;										// write to MAIN
+	case 0xC005: RAMWRT		= true;  break;										// write to AUX
+	case 0xC006: INTCXROM	= false; break;										// set peripheral roms for peripherals ($C100-$CFFF)
+	case 0xC007: INTCXROM	= true;  break;										// set internal rom for peripherals ($C100-$CFFF)
+	case 0xC008: ALTZP		= false; break;										// MAIN stack & rero page
+	case 0xC009: ALTZP		= true;  break;										// AUX stack & rero page
+	case 0xC00A: SLOTC3ROM	= false; break;										// ROM in Slot 3
+	case 0xC00B: SLOTC3ROM	= true;  break;										// ROM in AUX Slot
+	case 0xC00C: COL80		= false; return;									// 80 COL OFF -> 40 COL
+	case 0xC00D: COL80		= true;  return;									// 80 COL ON
+	case 0xC00E: ALTCHARSET = false; return;									// primary character set
+	case 0xC00F: ALTCHARSET = true;  return;									// alternate character set
+	}
+	if (mmuSwitches() != switches)
+		mmuRemap();
+}
+
+static uint8_t strobeRead(uint16_t address) { KBD &= 0x7F; return KBD; }		// $C010 KBDSTROBE
+static void strobeWrite(uint16_t address, uint8_t value) { KBD &= 0x7F; }
+
+static uint8_t statusRead(uint16_t address) {									// $C011-$C01F SOFT SWITCH STATUS FLAGS
+	switch (address) {
 	case 0xC011: return (0x80 * LCBK2);
 	case 0xC012: return (0x80 * LCRD);
 	case 0xC013: return (0x80 * RAMRD);											// 0x80 if reads from AUX
@@ -611,34 +858,32 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC016: return (0x80 * ALTZP);											// 0x80 if using stack and zero page from AUX
 	case 0xC017: return (0x80 * SLOTC3ROM);
 	case 0xC018: return (0x80 * STORE80);										// do we store 80 col page 2 on MAIN or AUX
-	case 0xC019: return (0x80 * VERTBLANK);
-
+	case 0xC019: return VERTBLANK ? 0x00 : 0x80;								// RDVBLBAR, MSB low during the vertical blanking
 	case 0xC01A: return (0x80 * TEXT);											// read text switch
 	case 0xC01B: return (0x80 * MIXED);											// read mixed switch
 	case 0xC01C: return (0x80 * PAGE2);											// read page 2 switch
 	case 0xC01D: return (0x80 * HIRES);											// read HiRes switch
 	case 0xC01E: return (0x80 * ALTCHARSET);									// alternate character set ?
 	case 0xC01F: return (0x80 * COL80);											// 80 columns on ?
+	}
+	return cpu.ticks % 0xFF;
+}
 
-	// SOUND
-	case 0xC020:																// TAPEOUT (shall we listen it ? - try SAVE from applesoft)
-	case 0xC030:																// SPEAKER
-	case 0xC033: playSound(); break;											// apple invader uses $C033 to output sound !
-
-	// GAME I/O STROBE OUT
-	case 0xC040: break;
+static void speakerWrite(uint16_t address, uint8_t value) { playSound(); }		// $C020 TAPEOUT, $C030 SPEAKER, $C033
+static uint8_t speakerRead(uint16_t address) { playSound(); return cpu.ticks % 0xFF; }
 
-	// VIDEO MODES
+static void videoWrite(uint16_t address, uint8_t value) {						// $C050-$C05F VIDEO MODES and ANNUNCIATORS
+	int switches = mmuSwitches();
+	switch (address) {
 	case 0xC050: TEXT  = false; break;											// Graphics
 	case 0xC051: TEXT  = true;	break;											// Text
 	case 0xC052: MIXED = false; break;											// Mixed off
 	case 0xC053: MIXED = true;	break;											// Mixed on
-	case 0xC054: PAGE2 = false; break;											// PAGE2 off
-	case 0xC055: PAGE2 = true;	break;											// PAGE2 on
-	case 0xC056: HIRES = false; break;											// HiRes off
-	case 0xC057: HIRES = true;	break;											// HiRes on
+	case 0xC054: PAGE2 = false; break;									// PAGE2 off
+	case 0xC055: PAGE2 = true;	break;									// PAGE2 on
+	case 0xC056: HIRES = false; break;									// HiRes off
+	case 0xC057: HIRES = true;	break;									// HiRes on
 
-	// ANNUNCIATORS
 	case 0xC058: if (!IOUDIS) AN0 = false; break;								// If IOUDIS off: Annunciator 0 Off
 	case 0xC059: if (!IOUDIS) AN0 = true;  break;								// If IOUDIS off: Annunciator 0 On
 	case 0xC05A: if (!IOUDIS) AN1 = false; break;								// If IOUDIS off: Annunciator 1 Off
@@ -647,11 +892,14 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC05D: if (!IOUDIS) AN2 = true;  break;								// If IOUDIS off: Annunciator 2 On
 	case 0xC05E: if (!IOUDIS) AN3 = false; DHIRES = true;  break;				// If IOUDIS off: Annunciator 3 Off
 	case 0xC05F: if (!IOUDIS) AN3 = true;  DHIRES = false; break;				// If IOUDIS off: Annunciator 2 On
+	}
+	if (mmuSwitches() != switches)												// PAGE2 and HIRES, with 80STORE
+		mmuRemap();
+}
+static uint8_t videoRead(uint16_t address) { videoWrite(address, 0); return cpu.ticks % 0xFF; }
 
-	// TAPE
-	case 0xC060: break;															// TAPE IN
-
-	// PADDLES
+static uint8_t gameRead(uint16_t address) {										// $C061-$C065
+	switch (address) {
 	case 0xC061: return PB0;													// Push Button 0 / Open Apple
 	case 0xC062: return PB1;													// Push Button 1 / Solid Apple
 	case 0xC063: return PB2;													// Push Button 2 / Shift
@@ -659,14 +907,21 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC065: return readPaddle(1);											// Paddle 1
 	//case 0xC066: return readPaddle(2);										// Paddle 2
 	//case 0xC067: return readPaddle(3);										// Paddle 3
+	}
+	return cpu.ticks % 0xFF;
+}
 
-	case 0xC070: resetPaddles(); break;											// paddle timer RST
+static void paddlesWrite(uint16_t address, uint8_t value) { resetPaddles(); }	// $C070 paddle timer RST
+static uint8_t paddlesRead(uint16_t address) { resetPaddles(); return cpu.ticks % 0xFF; }
 
-	// IOUDIS
-	case 0xC07E: if (WRT) IOUDIS = false; else return (0x80 * IOUDIS); break;
-	case 0xC07F: if (WRT) IOUDIS = true;  else return (0x80 * DHIRES); break;
+static uint8_t iouRead(uint16_t address) {										// $C07E IOUDIS, $C07F DHIRES
+	return address == 0xC07E ? 0x80 * IOUDIS : 0x80 * DHIRES;
+}
+static void iouWrite(uint16_t address, uint8_t value) { IOUDIS = address == 0xC07F; }
 
-	// LANGUAGE CARD (used with MAIN and AUX)
+static void languageCard(uint16_t address, bool WRT) {							// $C080-$C08F
+	int switches = mmuSwitches();
+	switch (address) {
 	case 0xC080:
 	case 0xC084: LCBK2 = 1; LCRD = 1; LCWR = 0;		 LCWFF = 0;	   break;		// LC2RD
 	case 0xC081:
@@ -683,342 +938,274 @@ uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
 	case 0xC08E: LCBK2 = 0; LCRD = 0; LCWR = 0;		 LCWFF = 0;	   break;		// ROMONLY1
 	case 0xC08B:
 	case 0xC08F: LCBK2 = 0; LCRD = 1; LCWR |= LCWFF; LCWFF = !WRT; break;		// LC1RW
-
-	// SLOT 1
-//	  case 0xC090 ... 0xC09F: break;
-
-	// SLOT 2
-//	  case 0xC0A0 ... 0xC0AF: break;
-
-	// SLOT 3
-//	  case 0xC0B0 ... 0xC0BF: break;
-
-	// SLOT 4
-//	  case 0xC0C0 ... 0xC0CF: break;
-
-	// SLOT 5
-//	  case 0xC0D0 ... 0xC0DF: break;
-
-	// SLOT 6 DISK ][
-	case 0xC0E0:
-	case 0xC0E1:
-	case 0xC0E2:
-	case 0xC0E3:
-	case 0xC0E4:
-	case 0xC0E5:
-	case 0xC0E6:
-	case 0xC0E7: stepMotorQ(address); break;									// MOVE DRIVE HEAD
-	//case 0xC0E7: stepMotor(address); break;									// MOVE DRIVE HEAD
-
-	case 0xC0E8: disk[curDrv].motorOn = false; break;							// MOTOROFF
-	case 0xC0E9: disk[curDrv].motorOn = true;  break;							// MOTORON
-
-	case 0xC0EA: setDrv(0); break;												// DRIVE0EN
-	case 0xC0EB: setDrv(1); break;												// DRIVE1EN
-
-	case 0xC0EC:																// Shift Data Latch
-		if (disk[curDrv].writeMode)												// writting
-			disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble]=dLatch;// good luck gcc
-		else																	// reading
-			dLatch=disk[curDrv].data[disk[curDrv].track*0x1A00+disk[curDrv].nibble];// easy peasy
-		disk[curDrv].nibble = (disk[curDrv].nibble + 1) % 0x1A00;				// turn floppy of 1 nibble
-		return dLatch;
-
-	case 0xC0ED: dLatch = value; break;											// Load Data Latch
-
-	case 0xC0EE:																// latch for READ
-		disk[curDrv].writeMode = false;
-		return disk[curDrv].readOnly ? 0x80 : 0;								// check protection
-
-	case 0xC0EF: disk[curDrv].writeMode = true; break;							// latch for WRITE
-  }
-  return ticks % 0xFF;															// catch all, gives a 'floating' value
-}
-
-
-//======================================================================= MEMORY
-// these two functions are imported into puce6502.c
-
-// a <= n <= b
-int uint16_in(uint16_t n, uint16_t a, uint16_t b)
-{
-	return n>=a && n<=b;
-}
-
-uint8_t readMem(uint16_t address) {
-	if(uint16_in(address,0x0000,0x01FF)) {	// STACK and Zero Page in AUX or MAIN
-		if(ALTZP) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x0200,0x03FF)) {										// MAIN or AUX
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x0400,0x07FF)) {										// TEXT PAGE 1 in AUX or MAIN
-		if(STORE80) {
-			if(PAGE2) return aux[address];
-			return ram[address];
-		}
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x0800,0x0BFF)) {										// TEXT PAGE 2 in AUX or MAIN
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x0C00,0x1FFF)) {										// AUX or MAIN
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x2000,0x3FFF)) {										// HIRES PAGE 1
-		if (STORE80) {
-			if(PAGE2 && HIRES) return aux[address];
-			return ram[address];
-		}
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x4000,0x5FFF)) {										// HIRES PAGE 2 in AUX or MAIN
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0x6000,0xBFFF)) {										// AUX or MAIN
-		if(RAMRD) return aux[address];
-		return ram[address];
-	}
-
-	if(uint16_in(address,0xC000,0xC0FF)) {										// SOFT SWITCHES
-		return softSwitches(address, 0, false);
 	}
+	if (mmuSwitches() != switches)												// LCWFF alone maps nothing
+		mmuRemap();
+}
+static uint8_t languageCardRead(uint16_t address) { languageCard(address, false); return cpu.ticks % 0xFF; }
+static void languageCardWrite(uint16_t address, uint8_t value) { languageCard(address, true); }
 
-	if(uint16_in(address,0xC100,0xC1FF)) {										// SLOT 1 ROM or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl1[address - SL1START];
+void ioInit() {
+	for (int address = 0x00; address <= 0xFF; address++) {
+		ioRead[address] = ioFloating;
+		ioWrite[address] = ioIgnore;
 	}
-
-	if(uint16_in(address,0xC200,0xC2FF)) {										// SLOT 2 ROM or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl2[address - SL2START];
+	ioRead[0x00] = kbdRead;
+	for (int address = 0x00; address <= 0x0F; address++)
+		ioWrite[address] = memoryWrite;
+	ioRead[0x10] = strobeRead;
+	ioWrite[0x10] = strobeWrite;
+	for (int address = 0x11; address <= 0x1F; address++)
+		ioRead[address] = statusRead;
+	ioRead[0x20] = ioRead[0x30] = ioRead[0x33] = speakerRead;
+	ioWrite[0x20] = ioWrite[0x30] = ioWrite[0x33] = speakerWrite;
+	for (int address = 0x50; address <= 0x5F; address++) {
+		ioRead[address] = videoRead;
+		ioWrite[address] = videoWrite;
 	}
+	for (int address = 0x61; address <= 0x65; address++)
+		ioRead[address] = gameRead;
+	ioRead[0x70] = paddlesRead;
+	ioWrite[0x70] = paddlesWrite;
+	ioRead[0x7E] = ioRead[0x7F] = iouRead;
+	ioWrite[0x7E] = ioWrite[0x7F] = iouWrite;
+	ioSlot(0, languageCardRead, languageCardWrite);
+}
 
-	if(uint16_in(address,0xC300,0xC3FF)) {										// SLOT 3 ROM  or ROM : video
-		if(INTCXROM || !SLOTC3ROM) return rom[address - ROMSTART];
-		return sl3[address - SL3START];
+void slotsInit() {
+	slots[6] = &diskCard;														// the cards this machine is built with
+	for (int slot = 1; slot < SLOTS; slot++) {
+		slot_card_t *card = slots[slot];
+		if (!card)
+			continue;
+		ioSlot(slot, card->read ? card->read : ioFloating, card->write ? card->write : ioIgnore);
+		slotRoms[slot] = card->expansion ? NULL : card->rom ? card->rom : slotRoms[slot];	// NULL : selects its expansion ROM
+#ifdef PUCE6502_CACHE
+		cache.io[0xC0 + slot] = !slotRoms[slot];								// run from there through readMem()
+#endif
+		if (card->init)
+			card->init(slot);
 	}
+}
 
-	if(uint16_in(address,0xC400,0xC4FF)) {										// SLOT 4 ROM or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl4[address - SL4START];
-	}
+void slotsReset() {
+	slotSelect(0);
+	for (int slot = 1; slot < SLOTS; slot++)
+		if (slots[slot] && slots[slot]->reset)
+			slots[slot]->reset(slot);
+}
 
-	if(uint16_in(address,0xC500,0xC5FF)) {										// SLOT 5 ROM or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl5[address - SL5START];
+//========================================== MEMORY MAPPED SOFT SWITCHES HANDLER
+// this function is called from readMem and writeMem
+// it complements both functions when address is in page $C0
+uint8_t softSwitches(uint16_t address, uint8_t value, bool WRT) {
+#ifdef PUCE6502_IDLE
+	if (address == 0xC000 && !WRT && !(KBD & 0x80))
+		idle.polls++;															// no key yet
+	else
+		idle.events++;															// anything else may end a wait
+#endif
+	if (WRT) {
+		ioWrite[address & 0xFF](address, value);
+		return 0;
 	}
+	return ioRead[address & 0xFF](address);
+}
 
-	if(uint16_in(address,0xC600,0xC6FF)) {										// SLOT 6 ROM : DISK ][ or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl6[address - SL6START];
-	}
 
-	if(uint16_in(address,0xC700,0xC7FF)) {										// SLOT 7 ROM or ROM
-		if(INTCXROM) return rom[address - ROMSTART];
-		return sl7[address - SL7START];
-	}
+//======================================================================= MEMORY
+// these two functions are the 6502 bus, see cpuRead() and cpuWrite()
 
-	if(uint16_in(address,0xC800,0xCFFE)) {										// SHARED EXANSION SLOTS ROM AREA or ROM
-		if(INTCXROM || !SLOTC3ROM) return rom[address - ROMSTART];
-		return slrom[(address & 0x0F00) >> 2 & 0xF][address - SLROMSTART];
-	}
+uint8_t readMem(uint16_t address) {
+	uint8_t *page = readPages[address >> 8];
+	if (page)
+		return page[address & 0xFF];											// RAM, AUX, ROM, LC or a slot ROM
 
-	if(address==0xCFFF) {// turn off all slots expansion ROMs - TODO : NEEDS REWORK
-		disk[curDrv].motorOn = false;
+	if (address == 0xCFFF) {													// turns off all slots expansion ROMs
+		slotSelect(0);
 		return 0;
 	}
+	if (address >= 0xCF00)														// SHARED EXANSION SLOTS ROM AREA or ROM
+		return INTCXROM || (!SLOTC3ROM && !slotC8) ? rom[address - ROMSTART] : slotExpansion[address - SLROMSTART];
+	if (address >= 0xC100)														// a card's page, selecting its expansion ROM
+		return slotAccess(address);
 
-	if(uint16_in(address,0xD000,0xDFFF)) {										// ROM, MAIN-BK1, RAM-BK2, AUX-BK1 or AUX-BK2
-		if(LCRD) {
-			if(LCBK2) {
-				if(ALTZP) return auxbk2[address - BK2START];					// AUX Bank 2
-				return rambk2[address - BK2START];								// MAIN Bank 2
-			}
-			if(ALTZP) return auxlgc[address - LGCSTART];						// AUX Bank 1
-			return ramlgc[address - LGCSTART];									// MAIN Bank 1
-		}
-		return rom[address - ROMSTART];											// ROM
-	}
-
-	if(uint16_in(address,0xE000,0xFFFF)) {										// ROM, MAIN-BK1	 or AUX-BK1
-		if(LCRD) {
-			if(ALTZP) return auxlgc[address - LGCSTART];						// AUX Bank 1
-			return ramlgc[address - LGCSTART];									// MAIN Bank 1
-		}
-		return rom[address - ROMSTART];											// ROM
-	}
-
-	return ticks%0xFF;															// returns a floating value
+	return softSwitches(address, 0, false);										// SOFT SWITCHES
 }
 
 void writeMem(uint16_t address, uint8_t value) {
-	if(uint16_in(address,0x0000,0x01FF)) {										// STACK and Zero Page in AUX or MAIN
-		if(ALTZP)
-			aux[address] = value;
-		else
-			ram[address] = value;
+	uint8_t *page = writePages[address >> 8];
+	if (page) {
+		page[address & 0xFF] = value;											// RAM, AUX or LC
+		videoDirty[address >> 7] = 1;											// whatever it is, cheaper than checking
 		return;
 	}
 
-	if(uint16_in(address,0x0200,0x03FF)) {										// MAIN or AUX
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
+	if (address == 0xCFFF) {													// turns off all slots expansion ROMs
+		slotSelect(0);
 		return;
 	}
-
-	if(uint16_in(address,0x0400,0x07FF)) {										// TEXT PAGE 1 in AUX or MAIN
-		if(STORE80) {
-			if(PAGE2)
-				aux[address] = value;
-			else
-				ram[address] = value;
-			return;
-		}
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
+	if (address >= 0xCF00)														// readonly area
 		return;
-	}
-
-	if(uint16_in(address,0x0800,0x0BFF)) {										// TEXT PAGE 2 in AUX or MAIN
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
+	if (address >= 0xC100) {													// a card's page, selecting its expansion ROM
+		slotAccess(address);
 		return;
 	}
 
-	if(uint16_in(address,0x0C00,0x1FFF)) {										// MAIN or AUX
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
-		return;
-	}
+	softSwitches(address, value, true);											// SOFT SWITCHES
+}
 
-	if(uint16_in(address,0x2000,0x3FFF)) {										// HIRES PAGE 1
-		if(STORE80) {
-			if(PAGE2 && HIRES)
-				aux[address] = value;
-			else
-				ram[address] = value;
-			return;
-		}
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
-		return;
-	}
+// callbacks of the cpu context
+static uint8_t cpuRead(puce6502_t *cpu, uint16_t address) { return readMem(address); }
+static void cpuWrite(puce6502_t *cpu, uint16_t address, uint8_t value) { writeMem(address, value); }
 
-	if(uint16_in(address,0x4000,0x5FFF)) {										// HIRES PAGE 2 in AUX or MAIN
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
-		return;
-	}
+#ifdef PUCE6502_TRAPS
+// busy-waits of the monitor ROM, run at once while it is mapped
 
-	if(uint16_in(address,0x6000,0xBFFF)) {										// AUX or MAIN
-		if(RAMWRT)
-			aux[address] = value;
-		else
-			ram[address] = value;
-		return;
-	}
+static void trapReturn(puce6502_t *cpu)											// the routine's RTS
+{
+	uint8_t low = readMem(0x100 + (uint8_t)(cpu->SP + 1));
+	uint8_t high = readMem(0x100 + (uint8_t)(cpu->SP + 2));
+	cpu->SP += 2;
+	cpu->PC = (high << 8 | low) + 1;
+}
 
-	if(uint16_in(address,0xC000,0xC0FF)) {										// softSwitches
-		softSwitches(address, value, true);
-		return;
-	}
+static unsigned int waitCycles(uint8_t a)										// WAIT, from its first instruction to its RTS
+{
+	return 7 + (5 * a * a + 27 * a) / 2;
+}
 
-	if(uint16_in(address,0xC100,0xCFFE)) {										// readonly area
-		return;
-	}
+static unsigned int trapWait(puce6502_t *cpu, unsigned long long int left)		// $FCA8 WAIT
+{
+	if (!cpu->A || cpu->P.D)													// 256 passes or decimal mode, left to the CPU
+		return 0;
+	if (!traps.skip && waitCycles(cpu->A) > left)								// past this run, the frame would end late
+		return 0;
+	unsigned int cycles = waitCycles(cpu->A);
+	writeMem(0x100 + cpu->SP, 0x01);											// its last PHA
+	cpu->A = 0;
+	setP(cpu, (getP(cpu) & 0x3C) | 0x03);										// N and V clear, Z and C set
+	trapReturn(cpu);
+	return cycles;
+}
 
-	if(address==0xCFFF) {// turn off all slots expansion ROMs - NEEDS REWORK soft switch ?
-		disk[curDrv].motorOn = false;
-		return;
-	}
+static unsigned int trapBell(puce6502_t *cpu, unsigned long long int left)		// $FBDD BELL1, only when not heard
+{
+	if (!traps.skip || cpu->P.D)												// its 192 clicks, WAIT still trapped
+		return 0;
+	writeMem(0x100 + cpu->SP, 0xFB);											// its last JSR WAIT
+	writeMem(0x100 + (uint8_t)(cpu->SP - 1), 0xE8);
+	writeMem(0x100 + (uint8_t)(cpu->SP - 2), 0x01);								// and the PHA in there
+	cpu->A = readMem(0xC030);													// the last click
+	cpu->Y = 0;
+	setP(cpu, (getP(cpu) & 0x3C) | 0x03);										// N and V clear, Z and C set
+	trapReturn(cpu);
+	return 8 + waitCycles(0x40) + 2 + 192 * (17 + waitCycles(0x0C)) - 1 + 6;
+}
+#endif
 
-	if(uint16_in(address,0xD000,0xDFFF)) {										// ROM, MAIN-BK1, RAM-BK2, AUX-BK1 or AUX-BK2
-		if(LCWR) {
-			if(LCBK2) {
-				if(ALTZP)
-					auxbk2[address - BK2START] = value;							// AUX Bank 2
-				else
-					rambk2[address - BK2START] = value;							// MAIN Bank 2
-				return;
-			}
-			if(ALTZP)
-				auxlgc[address - LGCSTART] = value;								// AUX Bank 1
-			else
-				ramlgc[address - LGCSTART] = value;								// MAIN Bank 1
-			return;
-		}
-		return;
-	}
+#ifdef PUCE6502_TRACE
+void traceSave()																// for puce6502trace to disassemble
+{
+	if (puce6502TraceSave(&cpu, "trace.bin"))
+		printf("last %u instructions saved to trace.bin\n", trace->count < PUCE6502_TRACE_SIZE ? (unsigned)trace->count : PUCE6502_TRACE_SIZE);
+}
 
-	if(uint16_in(address,0xE000,0xFFFF)) {										// ROM, MAIN-BK1	 or AUX-BK1
-		if(LCWR) {
-			if(ALTZP)
-				auxlgc[address - LGCSTART] = value;								// AUX Bank 1
-			else
-				ramlgc[address - LGCSTART] = value;								// MAIN Bank 1
-			return;
-		}
-		return;
-	}
+void traceCrash(int sig)														// the emulator itself crashed
+{
+	traceSave();
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+#endif
+
+#ifdef PUCE6502_STATS
+void statsSave()																// one CSV line per opcode
+{
+	if (puce6502StatsSave(&cpu, "stats.csv"))
+		printf("opcode counts saved to stats.csv\n");
 }
+#endif
 
 void CpuExec(unsigned long long int cycleCount)
 {
+#ifdef DASM_6502
 	unsigned int cycles_count=0;
 	unsigned int cycles=0;
 
-	while(cycles_count<cycleCount) {
-		cycles=puce6502Step();
+	while(cycles_count<cycleCount) {											// one instruction at a time to log it
+		cycles=puce6502Step(&cpu);
 		cycles_count += cycles;
-		ticks += cycles;
+		cpu.ticks += cycles;
 
-#ifdef DASM_6502
 		char disasm[256];
-		dasm(getPC(), disasm);
+		dasm(&cpu, getPC(&cpu), disasm);
 		LOG("%s\n", disasm);
+	}
+#else
+	schedRun(&sched, &cpu, cpu.ticks + cycleCount);								// stays in the CPU core up to each device event
 #endif
+#ifdef PUCE6502_TRACE
+	if (trace && trace->stopped) {												// the trigger fired
+		traceSave();
+		trace->stopped = 0;														// goes on tracing, the trigger stays fired
 	}
+#endif
 }
 
 void SysInit()
 {
+	puce6502Init();															// the CPU's tables
+	ioInit();																	// soft switches
+	cpu.readMem = cpuRead;
+	cpu.writeMem = cpuWrite;
+	schedInit(&sched);
+	schedAt(&sched, EVENT_VBL, cpu.ticks + VBL_SHOWN, vblStart);
+	slotsInit();																// and the cards, their events too
+#ifdef PUCE6502_TRAPS
+	traps.trap[traps.count++] = (puce6502_trap_t){ 0xFCA8, trapWait };
+	traps.trap[traps.count++] = (puce6502_trap_t){ 0xFBDD, trapBell };
+	cpu.traps = &traps;
+#endif
+#ifdef PUCE6502_CACHE
+	cache.io[0xC0] = cache.io[0xCF] = 1;										// soft switches and $CFFF
+	cpu.cache = &cache;
+#endif
+#ifdef PUCE6502_IDLE
+	cpu.idle = &idle;
+#endif
 	memset(ram,	0xFF, sizeof(ram));												// 48K of MAIN in $000-$BFFF
 	memset(aux,	0xFF, sizeof(aux));												// 48K of AUX memory
+#ifdef PUCE6502_TRACE
+	trace = calloc(1, sizeof(puce6502_trace_t));
+	if (trace) {
+		char *pc = getenv("REINETTE_TRACE_PC");									// hex address saving the trace when run
+		trace->trigger = pc ? (int)strtol(pc, NULL, 16) : -1;
+		trace->after = 1000;													// and the instructions following it
+		cpu.trace = trace;
+		signal(SIGSEGV, traceCrash);
+		signal(SIGABRT, traceCrash);
+	}
+#endif
+#ifdef PUCE6502_PROFILE
+	profile = calloc(1, sizeof(puce6502_profile_t));
+	cpu.profile = profile;
+#endif
+#ifdef PUCE6502_STATS
+	cpu.stats = &stats;
+#endif
 }
 
 void SysReset()
 {
 	apple2_reset();
+	puce6502CacheInvalidate(&cpu, 0x0000, 0xFFFF);								// memory and its mapping were reset
+	slotsReset();
+	mmuRemap();
+	memset(videoDirty, 1, sizeof(videoDirty));									// redraws the whole screen
 
 	// reset the CPU
-	puce6502RST();	// reset the 6502
+	puce6502RST(&cpu);	// reset the 6502
 }
 
 //=======================================================================
@@ -1064,6 +1251,32 @@ uint8_t caps_k( SDL_bool ctrl, SDL_bool shift, SDL_bool caps, uint8_t k1, uint8_
 		return shift?k2:k3;
 }
 
+//=================================================================== HGR DOTS
+// the color indices of the 7 dots of a HGR byte only depend on the byte, on
+// the dots on either side (bit 6 of the byte before, bit 0 of the one after)
+// and on the column's parity, one dot in two being darker : they are made once
+// per color mode and copied a byte at a time, each dot two pixels wide
+
+uint8_t hgrDots[2][2][2][256][14];												// [column & 1][left dot][next byte & 1][byte]
+int hgrColorMode = -1;															// the one hgrDots[] was made for
+
+void hgrInit(int color_mode)
+{
+	for (int odd = 0; odd < 2; odd++)
+		for (int left = 0; left < 2; left++)
+			for (int next = 0; next < 2; next++)
+				for (int byte = 0; byte < 256; byte++) {
+					uint16_t word = left | (byte & 0x7F) << 1 | next << 8;		// the dots, the ones on either side included
+					uint8_t colorSet = (byte & 0x80) ? 16 : 0;
+					for (int bit = 0; bit < 7; bit++) {
+						uint8_t even = (odd ^ (bit & 1)) ? 8 : 0;
+						uint8_t color = color_mode ? color_mode*32+16+ ((byte>>bit)&1) : 32*4+((word>>bit)&7) + even + colorSet;
+						memset(&hgrDots[odd][left][next][byte][bit * 2], color, 2);
+					}
+				}
+	hgrColorMode = color_mode;
+}
+
 //========================================================== PROGRAM ENTRY POINT
 
 int main(int argc, char *argv[]) {
@@ -1271,6 +1484,7 @@ int main(int argc, char *argv[]) {
 
 	enum characterAttribute { A_NORMAL, A_INVERSE, A_FLASH } glyphAttr;			// character attribute in TEXT
 	uint8_t flashCycle = 0;														// TEXT cursor flashes at 2Hz
+	int shownMode = -1, shownDrive = -1;										// of the last frame, see videoDirty
 
 	SDL_Rect drvRect[2] = { { 272*2, 188, 4*2, 4 }, { 276*2, 188, 4*2, 4 } };	// disk drive status squares
 
@@ -1336,8 +1550,16 @@ int main(int argc, char *argv[]) {
 
 	//========================================================== VM INITIALIZATION
 
-	if (argc > 1)
-		insertFloppy(wdo, argv[1], 0);											// load floppy if provided at command line
+	char *floppy = NULL;
+	for (int arg = 1; arg < argc; arg++) {										// reinette [-turbo] [floppy]
+		if (!strcmp(argv[arg], "-turbo"))
+			turbo = true;
+		else if (!floppy)
+			floppy = argv[arg];
+	}
+
+	if (floppy)
+		insertFloppy(wdo, floppy, 0);											// load floppy if provided at command line
 #ifdef LOADDSK
 	else {
 
@@ -1380,13 +1602,22 @@ int main(int argc, char *argv[]) {
 	while (running) {
 
 		if (!paused) {// the apple II is clocked at 1023000.0 Hhz
-			//puce6502Exec(17050);														// execute instructions for 1/60 of a second
+			//puce6502Exec(&cpu, 17050);												// execute instructions for 1/60 of a second
 			//while (disk[curDrv].motorOn && ++tries)									// until motor is off or i reaches 255+1=0
-			//	puce6502Exec(5000);														// speed up drive access artificially
+			//	puce6502Exec(&cpu, 5000);												// speed up drive access artificially
 
-			CpuExec(17050);																// execute instructions for 1/60 of a second
-			while (disk[curDrv].motorOn && ++tries)										// until motor is off or i reaches 255+1=0
-				CpuExec(5000);															// speed up drive access artificially
+			uint64_t turbo_end = SDL_GetTicks64() + 50/3;							// turbo : as many as fit in 1/60 of a second
+			do {
+#ifdef PUCE6502_IDLE
+				idle.idle = 0;
+#endif
+#ifdef PUCE6502_TRAPS
+				traps.skip = turbo;												// no time to wait for
+#endif
+				CpuExec(17050);															// execute instructions for 1/60 of a second
+				while (disk[curDrv].motorOn && ++tries)									// until motor is off or i reaches 255+1=0
+					CpuExec(5000);														// speed up drive access artificially
+			} while (turbo && SDL_GetTicks64() < turbo_end);
 		}
 
 
@@ -1460,6 +1691,7 @@ int main(int argc, char *argv[]) {
 						"alt F9\twrites the changes of the floppy in drive 1\n"
 						"\n"
 						"F11\tpause / un-pause the emulator\n"
+						"shift F11\tturbo on / off, sound off\n"
 						"\n"
 						"ctrl F12\treset\n"
 						"\n"
@@ -1494,7 +1726,7 @@ int main(int argc, char *argv[]) {
 						while (clipboardText[c]) {										// all chars until ascii NUL
 							KBD = clipboardText[c++] | 0x80;							// set bit7
 							if (KBD == 0x8A) KBD = 0x8D;								// translate Line Feed to Carriage Ret
-							puce6502Exec(400000);										// give cpu (and applesoft) some cycles to process each char
+							puce6502Exec(&cpu, 400000);									// give cpu (and applesoft) some cycles to process each char
 						}
 						SDL_free(clipboardText);										// release the ressource
 					}
@@ -1559,9 +1791,20 @@ int main(int argc, char *argv[]) {
 					{ticks_step=1;last_ticks=SDL_GetTicks64();}
 				break;
 
-				case SDLK_F10: debug = debug?0:1;break;
+				case SDLK_F10:
+#ifdef PUCE6502_TRACE
+					if (ctrl) { traceSave(); break; }									// CTRL-F10 saves the last instructions
+#endif
+#ifdef PUCE6502_STATS
+					if (shift) { statsSave(); break; }									// SHIFT-F10 saves the opcode counts
+#endif
+					debug = debug?0:1;break;
 
-				case SDLK_F11: paused = !paused; if(!paused){ticks_step=1;last_ticks=SDL_GetTicks64();} break;									// toggle pause
+				case SDLK_F11:
+					if (shift) turbo = !turbo;											// toggle turbo
+					else paused = !paused;												// toggle pause
+					if(!paused){ticks_step=1;last_ticks=SDL_GetTicks64();}
+					break;
 
 				case SDLK_F12: if (ctrl) SysReset(); break;						// simulate a reset
 
@@ -1655,54 +1898,52 @@ int main(int argc, char *argv[]) {
 		}
 
 		current_ticks = SDL_GetTicks64();
+		if (turbo) {															// the CPU set the pace, one frame shown
+			ticks_step = 1;
+			last_ticks = current_ticks;
+			break;
+		}
 		if( current_ticks-last_ticks > ticks_step*50/3 ) {						// ticks_step*1000/60 == ticks_step*50/3
 			ticks_step++;
 			//if(current_ticks-last_ticks>=1000 && ticks_step>=60) {last_ticks+=1000;ticks_step-=60;}
 			break;
 		}
+#ifdef PUCE6502_IDLE
+		if (idle.idle)															// the CPU waits for a key, so does the host
+			SDL_WaitEventTimeout(NULL, last_ticks + ticks_step*50/3 + 1 - current_ticks);
+#endif
 
 		}	// while
 
 		//============================================================= VIDEO OUTPUT
+		// only the lines whose bytes were written since the last frame are
+		// redrawn, all of them when the mode changed, and the text when it flashes
+
+		int mode = TEXT | MIXED << 1 | PAGE2 << 2 | HIRES << 3 | DHIRES << 4 | COL80 << 5 | STORE80 << 6 | color_mode << 7;
+		bool redrawAll = mode != shownMode;
+		bool flashing = flashCycle == 0 || flashCycle == 15;					// the FLASH characters turn over
+		bool redrawn = redrawAll;
+		shownMode = mode;
 
 		// HIGH RES GRAPHICS
 		if (!TEXT && HIRES && !DHIRES) {
-			uint16_t word;
-			uint8_t colorSet, even;
 			uint16_t vRamBase = 0x2000 + PAGE2 * 0x2000;
 			uint8_t lastLine = MIXED ? 160 : 192;
-			uint16_t byte_1, byte_2;
-			//uint8_t bits[16], pbit;
-			//uint8_t colorIdx = 0;												// to index the color arrays
-			int bit;
+			if (hgrColorMode != color_mode)										// F8 was pressed
+				hgrInit(color_mode);
 
 			for (int line = 0; line < lastLine; line++) {						// for every line
-				int off = line*SCREEN_RES_W;
-
-				word = 0;
-				byte_1 = ram[vRamBase + offsetHGR[line] + 0+0];
-				byte_2 = 0;
-				even = 0;
-				for (int col = 0; col < 40; col ++) {							// for every 7 horizontal dots
-					if(col==39)
-						byte_2 = 0;
-					else
-						byte_2 = ram[vRamBase + offsetHGR[line] + col+1];
-
-					colorSet = (byte_1&0x80)?16:0;
-					word = word | ((byte_1&0x007f)<<1) | ((byte_2&0x0001)<<8);
-
-					for (bit=0; bit<7; bit++) {
-						if(color_mode)
-							screenData[off+1]=screenData[off] = color_mode*32+16+ ((byte_1>>bit)&1);
-						else
-							screenData[off+1]=screenData[off] = 32*4+((word>>bit)&7) + even + colorSet;
-						even = even?0:8;
-						off+=2;
-					}
-
-					word = (byte_1>>6)&1;
-					byte_1=byte_2;
+				if (!redrawAll && !videoDirty[(vRamBase + offsetHGR[line]) >> 7])
+					continue;
+				redrawn = true;
+				uint8_t *dots = screenData + line*SCREEN_RES_W;
+				uint8_t *bytes = ram + vRamBase + offsetHGR[line];
+				uint8_t left = 0;												// bit 6 of the byte before
+				for (int col = 0; col < 40; col++) {							// for every 7 horizontal dots
+					uint8_t next = col < 39 ? bytes[col + 1] & 1 : 0;
+					memcpy(dots, hgrDots[col & 1][left][next][bytes[col]], 14);
+					dots += 14;
+					left = (bytes[col] >> 6) & 1;
 				}
 			}
 
@@ -1753,6 +1994,9 @@ int main(int argc, char *argv[]) {
 				BWmode = STORE80;
 
 				for (int line = 0; line < lastLine; line++) {					// for every line
+					if (!redrawAll && !videoDirty[(vRamBase + offsetHGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					int off = line*SCREEN_RES_W;
 
 					for (int col = 0; col < 40; col+=2) {						// for every 28 horizontal dots
@@ -1804,6 +2048,9 @@ int main(int argc, char *argv[]) {
 				}
 			} else {
 				for (int line = 0; line < lastLine; line++) {					// for every line
+					if (!redrawAll && !videoDirty[(vRamBase + offsetHGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					int off = line*SCREEN_RES_W;
 
 					for (int col = 0; col < 40; col++) {						// for every 7 horizontal dots
@@ -1836,6 +2083,9 @@ int main(int argc, char *argv[]) {
 
 			for (int col = 0; col < 40; col++) {								// for each column
 				for (int line = 0; line < lastLine; line++) {					// for each row
+					if (!redrawAll && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					glyph = ram[vRamBase + offsetGR[line] + col];				// read video memory
 
 					colorIdx = glyph & 0x0F;									// first nibble
@@ -1869,6 +2119,9 @@ int main(int argc, char *argv[]) {
 
 			for (int col = 0; col < 40; col++) {								// for each column
 			  for (int line = 0; line < endRaw; line++) {						// for each row
+				if (!redrawAll && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+					continue;
+				redrawn = true;
 				glyph = aux[vRamBase + offsetGR[line] + col];					// read AUX video memory
 
 				colorIdx = glyph & 0x0F;										// first nibble
@@ -1919,6 +2172,9 @@ int main(int argc, char *argv[]) {
 
 			for (int col = 0; col < 40; col++) {								// for each column
 				for (int line = firstLine; line < 24; line++) {					// for each row
+					if (!redrawAll && !flashing && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+						continue;
+					redrawn = true;
 					glyph = ram[vRamBase + offsetGR[line] + col];				// read video memory
 					if (glyph > 0x7F) glyphAttr = A_NORMAL;						// is NORMAL ?
 					else if (glyph < 0x40) glyphAttr = A_INVERSE;				// is INVERSE ?
@@ -1966,6 +2222,9 @@ int main(int argc, char *argv[]) {
 
 			for (int col = 0; col < 40; col++) {								// for each column
 				for (int line = firstLine; line < 24; line++) {					// for each row
+					if (!redrawAll && !flashing && !videoDirty[(vRamBase + offsetGR[line]) >> 7])
+						continue;
+					redrawn = true;
 
 					glyph = aux[vRamBase + offsetGR[line] + col];				// read video memory
 					if (glyph > 0x7F) glyphAttr = A_NORMAL;						// is NORMAL ?
@@ -2040,11 +2299,19 @@ int main(int argc, char *argv[]) {
 
 		if (++flashCycle == 30)													// increase cursor flash cycle
 			flashCycle = 0;														// reset to zero every half second
-
-		Uint32 fmt = sdlSurface->format->format;
-		SDL_Surface *surf = SDL_ConvertSurfaceFormat(sdlScreen, fmt, 0);
-		SDL_BlitScaled(surf,NULL,sdlSurface,NULL);
-		SDL_FreeSurface(surf);
+		memset(videoDirty, 0, sizeof(videoDirty));
+
+		int drive = disk[curDrv].motorOn ? 1 + curDrv * 2 + disk[curDrv].writeMode : 0;
+		if (drive != shownDrive)												// its square is drawn over the screen
+			redrawn = true;
+		shownDrive = drive;
+
+		if (redrawn) {															// else the same as the last frame
+			Uint32 fmt = sdlSurface->format->format;
+			SDL_Surface *surf = SDL_ConvertSurfaceFormat(sdlScreen, fmt, 0);
+			SDL_BlitScaled(surf,NULL,sdlSurface,NULL);
+			SDL_FreeSurface(surf);
+		}
 
 		//====================================================== DISPLAY DISK STATUS
 		// red for writes
@@ -2069,5 +2336,12 @@ int main(int argc, char *argv[]) {
 
 	SDL_AudioQuit();
 	SDL_Quit();
+#ifdef PUCE6502_PROFILE
+	if (puce6502ProfileReport(&cpu, "profile.txt", 50) && puce6502ProfileStacks(&cpu, "profile.folded"))
+		printf("profile saved to profile.txt and profile.folded\n");		// the latter for flame graphs
+#endif
+#ifdef PUCE6502_STATS
+	statsSave();
+#endif
 	return 0;
 }
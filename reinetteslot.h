@@ -0,0 +1,44 @@
+/*
+  reinette - peripheral cards
+
+  A card is a slot_card_t the machine plugs in one of its slots when it is
+  built, see slotsInit() in reinetteII+.c and reinetteIIe.c : its handlers are
+  written into the $C0n0-$C0nF entries of the soft switches dispatch table and
+  its ROM into the page tables, once. Nothing is checked per access, an empty
+  slot costs nothing and a card with no expansion ROM no more than the RAM.
+
+  A card with an expansion ROM has its $Cn00-$CnFF page sent to the slow path
+  instead : an access there selects its ROM for $C800-$CFFE, until the next
+  access to $CFFF or to the page of another such card. $CFFF, and a reset,
+  deselect them all : every card is told through release, what it does then is
+  its own business.
+
+  A card's events run on the machine's scheduler, see puce6502sched.h : it
+  asks for one with slotAt(), its event function is then called with the slot
+  and the ticks value it was due at.
+*/
+
+#ifndef _REINETTESLOT_H
+#define _REINETTESLOT_H
+
+#include <stdint.h>
+
+// handlers of one soft switch address, $C000-$C0FF
+typedef uint8_t (*ioRead_t)(uint16_t address);
+typedef void (*ioWrite_t)(uint16_t address, uint8_t value);
+
+typedef struct {
+	const char *name;
+	void (*init)(int slot);  // once, when plugged in, after its handlers were set : NULL if nothing to do
+	void (*reset)(int slot);  // at each reset of the machine, NULL if nothing to do
+	ioRead_t read;  // $C0n0-$C0nF, n being slot + 8 : NULL for none
+	ioWrite_t write;
+	uint8_t *rom;  // the 256 bytes at $Cn00, NULL for none
+	uint8_t *expansion;  // the 2K at $C800, NULL for none
+	void (*event)(int slot, unsigned long long int due);  // asked for by slotAt(), NULL for none
+	void (*release)(int slot);  // at each access to $CFFF and at reset, NULL if nothing to do
+} slot_card_t;
+
+#define SLOTS 8  // slot 0 is the II+ language card's, not a slot_card_t
+
+#endif